@@ -1,7 +1,10 @@
 #ifndef CAMERA_HANDLER_HPP_
 #define CAMERA_HANDLER_HPP_
 
+#include <cstdint>
+
 #include <opencv2/opencv.hpp>
+#include "pixel_format.hpp"
 
 class CameraHandler
 {
@@ -16,20 +19,72 @@ public:
     CameraHandler & operator = (const CameraHandler &) = delete;
 
     bool Open(int id, int width, int height, int fps);
+    /**
+     * @brief open a video file, stream URL or GStreamer pipeline, the requested size and FPS are ignored
+     */
+    bool Open(const std::string &source, int width, int height, int fps);
     void Close();
     bool IsOpened() const;
+    /**
+     * @brief read the next frame
+     * @param frame     next frame, empty if it could not be decoded or has an unexpected size and was skipped
+     * @return false only if reading failed, i.e. the camera was disconnected or the stream ended
+     */
     bool GetFrame(cv::Mat &frame);
+    /**
+     * @brief number of frames skipped by GetFrame since they could not be decoded or had an unexpected size
+     */
+    uint64_t GetSkippedCount() const;
     int GetActualWidth() const;
     int GetActualHeight() const;
+    int GetActualFPS() const;
+    /**
+     * @brief factor the frames returned by GetFrame are downscaled by from the capture resolution,
+     *        the IDCT scaling denominator for MJPEG and 1 otherwise
+     */
+    int GetFrameScale() const;
+    bool IsDevice() const;
 
     void SetResolution(int width, int height);
     void SetFPS(int fps);
+
+    /**
+     * @brief set the pixel format of frames returned by GetFrame, must be called before Open
+     * @param format    BGR decodes frames with OpenCV, YUYV and NV12 return raw camera buffers
+     */
+    void SetPixelFormat(Infer::PixelFormat format);
+    Infer::PixelFormat GetPixelFormat() const;
+
+    /**
+     * @brief capture MJPEG and decode it at reduced size with a scaled IDCT, must be called before Open
+     * @param enable        whether to capture MJPEG
+     * @param min_size      minimum long side of decoded frames, typically the letterbox target size
+     */
+    void SetMJPEG(bool enable, int min_size);
 private:
     cv::VideoCapture camera_;
     int camera_id_;
+    std::string source_;    // non-empty for files and streams
     int frame_width_;
     int frame_height_;
     int fps_;
+    Infer::PixelFormat format_ = Infer::PixelFormat::BGR;
+
+    bool mjpeg_ = false;
+    int mjpeg_min_size_ = 0;
+    int mjpeg_denom_ = 1;           // IDCT scaling denominator: 1, 2, 4 or 8
+    cv::Mat jpeg_;                  // raw MJPEG buffer of the last frame
+    void *jpeg_decoder_ = nullptr;  // turbojpeg handle
+    uint64_t skipped_ = 0;          // frames that could not be decoded or shaped
+
+    bool DecodeMJPEG(cv::Mat &frame);
+
+    /**
+     * @brief give a raw YUYV or NV12 buffer the shape of a frame
+     * @param frame     raw buffer, replaced by a h x w CV_8UC2 (YUYV) or h*3/2 x w CV_8UC1 (NV12) header
+     * @return false if the byte count does not match the frame size
+     */
+    bool ShapeRawFrame(cv::Mat &frame) const;
 
     bool InitCamera();
 };
@@ -1,7 +1,13 @@
 #ifndef BASE_DETECTOR_HPP_
 #define BASE_DETECTOR_HPP_
 
+#include <memory>
+#include <vector>
+#include <cstdint>
+
 #include <opencv2/opencv.hpp>
+#include "pixel_format.hpp"
+#include "detectors/proposal_arena.hpp"
 
 namespace Infer
 {
@@ -13,6 +19,24 @@ struct Object
     cv::Rect_<float> rect;
 };
 
+// view of an output head in NHWC layout, grid rows may be padded
+struct FeatureView
+{
+    const float *data;
+    std::array<int, 4> nhwc_shape;
+    size_t row_step;    // number of floats between grid rows, at least W x C
+};
+
+// post-processing settings that can change between detections without reinitializing
+struct PostprocessSettings
+{
+    float conf_thres = 0.25f;
+    float nms_thres = 0.45f;
+    int max_candidates = 0;         // 0 for no limit
+    int max_detections = 0;         // 0 for no limit
+    std::vector<int> class_filter;  // allowed class indexes, empty for all classes
+};
+
 class BaseDetector
 {
 public:
@@ -33,6 +57,14 @@ public:
      */
     virtual std::vector<Object> Detect(const cv::Mat &bgr) = 0;
 
+    /**
+     * @brief detect objects in a frame of any supported pixel format
+     * @param frame     frame to be detected
+     * @param format    pixel format of the frame
+     * @return vector of detected objects
+     */
+    virtual std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format);
+
     /**
      * @brief initialize the inference framework
      * @param threads                   number of inference threads
@@ -47,6 +79,54 @@ public:
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) = 0;
     
+    /**
+     * @brief create a detector that shares the loaded model weights with this one,
+     *        each instance keeps its own inference state so that they can run concurrently
+     * @return initialized detector, nullptr if the framework does not support sharing
+     */
+    virtual std::unique_ptr<BaseDetector> CreateSharedInstance();
+
+    /**
+     * @brief set whether the model outputs raw logits, i.e. it was exported without the final sigmoid
+     * @param raw_logits    whether scores and box offsets are logits
+     */
+    void SetRawLogits(const bool raw_logits);
+
+    /**
+     * @brief bound the post-processing cost in crowded scenes
+     * @param max_candidates    maximum number of proposals passed to NMS, the best scores are kept, 0 for no limit
+     * @param max_detections    maximum number of detections returned, 0 for no limit
+     */
+    void SetDetectionLimits(const int max_candidates, const int max_detections);
+
+    /**
+     * @brief change the confidence threshold after initialization
+     * @param conf_thres    confidence threshold
+     */
+    void SetConfThreshold(const float conf_thres);
+    float GetConfThreshold() const;
+
+    /**
+     * @brief only detect some classes, an anchor takes the best of the allowed classes
+     *        and other classes are not scanned
+     * @param class_filter  allowed class indexes, empty for all classes
+     */
+    void SetClassFilter(const std::vector<int> &class_filter);
+
+    /**
+     * @brief change all post-processing settings after initialization, not thread-safe with Detect
+     * @param settings  thresholds, limits and class filter
+     */
+    virtual void SetPostprocessSettings(const PostprocessSettings &settings);
+
+    /**
+     * @brief change the letterbox target size after initialization
+     * @param target_size   long side of the letterbox, a multiple of the maximum stride
+     * @return whether the framework supports the size
+     */
+    virtual bool SetTargetSize(const int target_size);
+    int GetTargetSize() const;
+
     /**
      * @brief draw detected objects on an image
      * @param image     image to draw
@@ -64,7 +144,20 @@ protected:
     int target_size_;
     int max_stride_;
     int num_class_;
+    int threads_ = 1;
     bool isInited_ = false;
+    bool raw_logits_ = false;
+    float conf_logit_ = 0.0f;       // conf_thres_ in logit space for raw logit models
+    int max_candidates_ = 0;
+    int max_detections_ = 0;
+    std::vector<uint8_t> class_allowed_;    // indexed by class, empty if all classes are allowed
+    std::vector<int> class_indexes_;        // allowed classes in ascending order, empty if all are allowed
+
+    // post-processing buffers reused across frames
+    ProposalArena proposals_;       // decoded proposals of all strides
+    std::vector<ProposalArena> band_proposals_;     // proposals of each parallel decoding task
+    ProposalArena kept_;            // proposals kept by NMS
+    std::vector<int> order_;        // proposal indices sorted by score
 
     std::array<int, 3> strides_ = {8, 16, 32};
     std::array<std::array<float, 6>, 3> anchors_ = {{
@@ -73,6 +166,12 @@ protected:
         {116.0f, 90.0f, 156.0f, 198.0f, 373.0f, 326.0f}
     }};
 
+    /**
+     * @brief copy thresholds and model settings from an initialized detector
+     * @param other     detector to copy from
+     */
+    void CopySettings(const BaseDetector &other);
+
     template <typename T>
     T Clamp(T x, T min_x, T max_x)
     {
@@ -90,25 +189,80 @@ protected:
         int &resize_rows, int &resize_cols, int &pad_rows, int &pad_cols, float &scale);
 
     /**
-     * @brief generate proposals from feature blob
-     * @param feat_blob     feature blob
-     * @param nhwc_shape    blob shape in NHWC layout
-     * @param stride        downsampling stride
-     * @param anchors       anchors for the current stride
-     * @param proposals     generated proposals from the blob
+     * @brief get image size of a frame
+     * @param frame                 frame in any supported pixel format
+     * @param format                pixel format of the frame
+     * @param img_rows, img_cols    image size
      */
-    virtual void GenerateProposals(const float *feat_blob, const std::array<int, 4> nhwc_shape, int stride,
-        const std::array<float, 6> &anchors, std::vector<Object> &proposals);
+    void GetImageSize(const cv::Mat &frame, const PixelFormat format, int &img_rows, int &img_cols);
 
     /**
-     * @brief perform non-maximum suppression
+     * @brief create letterbox from a YUV frame in one pass, fusing color conversion, bilinear resize,
+     *        normalization and padding
+     * @param frame                     YUYV or NV12 frame
+     * @param format                    pixel format of the frame
+     * @param resize_rows, resize_cols  letterbox resize size
+     * @param pad_rows, pad_cols        letterbox padding size
+     * @param planes                    R, G, B output planes of (resize_rows + pad_rows) x (resize_cols + pad_cols)
+     */
+    void LetterboxYUV(const cv::Mat &frame, const PixelFormat format,
+        const int resize_rows, const int resize_cols, const int pad_rows, const int pad_cols,
+        const std::array<float *, 3> &planes);
+
+    /**
+     * @brief generate proposals from all output heads in parallel, split by head and by row band
+     * @param heads         output heads in the order of strides_
+     * @param proposals     generated proposals, replaced
+     */
+    void GenerateProposals(const std::array<FeatureView, 3> &heads, ProposalArena &proposals);
+
+    /**
+     * @brief generate proposals from a band of grid rows of an output head
+     * @param head                  output head
+     * @param row_begin, row_end    grid rows to decode, batches are stacked along the rows
+     * @param stride                downsampling stride
+     * @param anchors               anchors for the current stride
+     * @param proposals             arena the proposals are appended to
+     */
+    virtual void GenerateProposals(const FeatureView &head, const int row_begin, const int row_end,
+        int stride, const std::array<float, 6> &anchors, ProposalArena &proposals);
+
+    /**
+     * @brief perform class-agnostic non-maximum suppression
      * @param proposals         raw proposals
      * @param objects           object detection results
      * @param orig_h, orig_w    original image size
      * @param dh, dw            padding size applied to the height and width
      * @param ratio_h, ratio_w  scaling ratios applied to height and width
      */
-    virtual void NMS(std::vector<Object> &proposals, std::vector<Object> &objects,
+    virtual void NMS(const ProposalArena &proposals, std::vector<Object> &objects,
+        const int orig_h, const int orig_w,
+        const float dh, const float dw,
+        const float ratio_h, const float ratio_w);
+
+    /**
+     * @brief convert final detections of a model with embedded decoding and NMS
+     * @param detections        detections in letterbox space, each as x0, y0, x1, y1, score, label
+     * @param count             number of detections
+     * @param objects           object detection results
+     * @param orig_h, orig_w    original image size
+     * @param dh, dw            padding size applied to the height and width
+     * @param ratio_h, ratio_w  scaling ratios applied to height and width
+     */
+    virtual void ParseDetections(const float *detections, const int count, std::vector<Object> &objects,
+        const int orig_h, const int orig_w,
+        const float dh, const float dw,
+        const float ratio_h, const float ratio_w);
+
+    /**
+     * @brief map a box from letterbox space back to the original image
+     * @param x0, y0, x1, y1    box corners in letterbox space
+     * @param orig_h, orig_w    original image size
+     * @param dh, dw            padding size applied to the height and width
+     * @param ratio_h, ratio_w  scaling ratios applied to height and width
+     * @return box in the original image
+     */
+    cv::Rect_<float> UnletterboxBox(float x0, float y0, float x1, float y1,
         const int orig_h, const int orig_w,
         const float dh, const float dw,
         const float ratio_h, const float ratio_w);
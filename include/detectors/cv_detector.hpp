@@ -3,6 +3,7 @@
 
 #include "detectors/base_detector.hpp"
 #include <string>
+#include <vector>
 #include <memory>
 
 #include <opencv2/opencv.hpp>
@@ -17,12 +18,48 @@ public:
     ~CVDetector();
 
     std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
     bool Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) override;
+    bool SetTargetSize(const int target_size) override;
 
 private:
-    cv::dnn::Net net_;
+    // OpenCV dnn cannot change input shapes at runtime, so one net is loaded per fixed input shape
+    struct ShapeBucket
+    {
+        cv::Size size;
+        cv::dnn::Net net;
+    };
+    std::vector<ShapeBucket> buckets_;
+    std::string model_path_;    // model file path without file extension
+
+    /**
+     * @brief load the shape buckets of a target size that are not loaded yet,
+     *        the square bucket of the initial size is mandatory
+     * @param target_size   letterbox target size
+     * @return whether any bucket is loaded
+     */
+    bool LoadBuckets(const int target_size);
+
+    /**
+     * @brief select the smallest bucket that fits the resized image
+     * @param resize_rows, resize_cols  letterbox resize size
+     * @return the selected bucket
+     */
+    ShapeBucket & SelectBucket(const int resize_rows, const int resize_cols);
+
+    /**
+     * @brief run inference and postprocessing on a blob
+     * @param blob                      normalized RGB letterbox in NCHW layout
+     * @param bucket                    bucket matching the blob size
+     * @param img_rows, img_cols        original image size
+     * @param pad_rows, pad_cols        letterbox padding size
+     * @param scale                     letterbox scaling ratio
+     * @return vector of detected objects
+     */
+    std::vector<Object> Run(const cv::Mat &blob, ShapeBucket &bucket, const int img_rows, const int img_cols,
+        const int pad_rows, const int pad_cols, const float scale);
 };
 
 }
@@ -0,0 +1,64 @@
+#ifndef FAST_MATH_HPP_
+#define FAST_MATH_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace Infer
+{
+
+/**
+ * @brief exp with a relative error below 1e-5, written without branches so that loops over it vectorize
+ * @param x     exponent, clamped to the normal float range
+ * @return approximation of e^x
+ */
+inline float FastExp(float x)
+{
+    // e^x = 2^n * 2^f with n = round(x * log2(e)) and f in [-0.5, 0.5]
+    x = std::min(std::max(x, -87.0f), 88.0f);
+    const float t = x * 1.44269504088896341f;
+    const float n = std::floor(t + 0.5f);
+    const float f = t - n;
+    // polynomial for 2^f from Cephes exp2f
+    float p = 1.535336188319500e-4f;
+    p = p * f + 1.339887440266574e-3f;
+    p = p * f + 9.618437357674640e-3f;
+    p = p * f + 5.550332471162809e-2f;
+    p = p * f + 2.402264791363012e-1f;
+    p = p * f + 6.931472028550421e-1f;
+    p = p * f + 1.0f;
+    // 2^n built directly in the exponent bits
+    const int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+/**
+ * @brief apply sigmoid in place
+ * @param values    values to be converted
+ * @param count     number of values
+ */
+inline void FastSigmoid(float *values, const int count)
+{
+    #pragma omp simd
+    for (int i = 0; i < count; ++i)
+        values[i] = 1.0f / (1.0f + FastExp(-values[i]));
+}
+
+/**
+ * @brief inverse of sigmoid, maps a probability threshold to logit space
+ * @param p     probability, clamped to (0, 1)
+ * @return logit of p
+ */
+inline float Logit(float p)
+{
+    p = std::min(std::max(p, 1e-7f), 1.0f - 1e-7f);
+    return std::log(p / (1.0f - p));
+}
+
+}   // namespace Infer
+
+#endif  // FAST_MATH_HPP_
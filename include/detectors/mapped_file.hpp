@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <string>
+#include <vector>
+
+namespace Infer
+{
+
+// read-only memory mapping of a file, pages are loaded on first access and shared between processes
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // disable copy and move since the mapping is an exclusive resource
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile & operator=(MappedFile &&) = delete;
+
+    /**
+     * @brief map a file, platforms without mmap read it into memory instead
+     * @param path  file path
+     * @return whether the file was mapped
+     */
+    bool Open(const std::string &path);
+    void Close();
+
+    const unsigned char * Data() const;
+    size_t Size() const;
+
+private:
+    void *data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<unsigned char> buffer_;     // fallback without mmap
+};
+
+}   // namespace Infer
+
+#endif  // MAPPED_FILE_HPP_
@@ -2,9 +2,12 @@
 #define MNN_DETECTOR_HPP_
 
 #include "detectors/base_detector.hpp"
+#include "detectors/mapped_file.hpp"
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <map>
 
 #include <opencv2/opencv.hpp>
 #include <MNN/Interpreter.hpp>
@@ -15,18 +18,53 @@ namespace Infer
 class MNNDetector : public BaseDetector
 {
 public:
-    MNNDetector();
+    /**
+     * @param memory_map    whether to load the model from a memory-mapped file
+     */
+    explicit MNNDetector(const bool memory_map = false);
     ~MNNDetector();
 
     std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
     bool Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) override;
+    std::unique_ptr<BaseDetector> CreateSharedInstance() override;
 
 private:
-    std::unique_ptr<MNN::Interpreter> net_ = nullptr;
-    MNN::Session *session_ = nullptr;
+    bool memory_map_;
+    // shared instances create their own sessions on the same interpreter,
+    // the interpreter is not thread-safe when creating or resizing sessions
+    std::shared_ptr<MNN::Interpreter> net_ = nullptr;
+    std::shared_ptr<std::mutex> net_mutex_ = std::make_shared<std::mutex>();
+    MNN::Session *session_ = nullptr;   // created on initialization, the first entry of sessions_ once used
+    // one session per input rows and cols, so that switching target sizes does not resize in the frame path
+    std::map<std::pair<int, int>, MNN::Session *> sessions_;
     std::vector<std::string> output_names_;
+
+    /**
+     * @brief create a session of this instance on the loaded interpreter
+     * @return created session, nullptr on failure
+     */
+    MNN::Session * CreateSession();
+
+    /**
+     * @brief get the session sized for an input, created and resized on first use
+     * @param rows, cols    input size
+     * @return session, nullptr on failure
+     */
+    MNN::Session * GetSession(const int rows, const int cols);
+
+    /**
+     * @brief run inference and postprocessing on a host tensor
+     * @param host_tensor               normalized RGB letterbox
+     * @param img_rows, img_cols        original image size
+     * @param pad_rows, pad_cols        letterbox padding size
+     * @param scale                     letterbox scaling ratio
+     * @return vector of detected objects
+     */
+    std::vector<Object> Run(const MNN::Tensor *host_tensor, const int img_rows, const int img_cols,
+        const int pad_rows, const int pad_cols, const float scale);
 };
 
 }   // namespace Infer
@@ -2,8 +2,10 @@
 #define NCNN_DETECTOR_HPP_
 
 #include "detectors/base_detector.hpp"
+#include "detectors/mapped_file.hpp"
 #include <string>
 #include <vector>
+#include <memory>
 
 #include <opencv2/opencv.hpp>
 #include "net.h"
@@ -14,27 +16,36 @@ namespace Infer
 class NCNNDetector : public BaseDetector
 {
 public:
-    NCNNDetector();
+    /**
+     * @param memory_map    whether to reference weights in a memory-mapped .bin file instead of copying them
+     */
+    explicit NCNNDetector(const bool memory_map = false);
     ~NCNNDetector();
 
     std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
     bool Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) override;
+    std::unique_ptr<BaseDetector> CreateSharedInstance() override;
 
 private:
-    ncnn::Net net_;
+    bool memory_map_;
+    // mapped .bin file referenced by the net, declared first so that it is released last
+    std::shared_ptr<MappedFile> model_file_ = nullptr;
+    // read-only after loading, shared instances create their own extractors
+    std::shared_ptr<ncnn::Net> net_ = std::make_shared<ncnn::Net>();
 
     /**
-     * @brief generate proposals with ncnn specific way
-     * @param feat_blob     feature blob
-     * @param stride        downsampling stride
-     * @param anchors       anchors for the current stride
-     * @param proposals     generated proposals from the blob
+     * @brief run inference and postprocessing on a letterbox
+     * @param letterbox                 normalized RGB letterbox
+     * @param img_rows, img_cols        original image size
+     * @param pad_rows, pad_cols        letterbox padding size
+     * @param scale                     letterbox scaling ratio
+     * @return vector of detected objects
      */
-    void GenerateProposals(const ncnn::Mat &feat_blob, int stride,
-        const std::array<float, 6> &anchors, std::vector<Object> &proposals);
-    using BaseDetector::GenerateProposals;
+    std::vector<Object> Run(const ncnn::Mat &letterbox, const int img_rows, const int img_cols,
+        const int pad_rows, const int pad_cols, const float scale);
 };
 
 }   // namespace Infer
@@ -18,16 +18,34 @@ public:
     ~ORTDetector();
 
     std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
     bool Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) override;
+    std::unique_ptr<BaseDetector> CreateSharedInstance() override;
 
 private:
-    Ort::Env env_;
-    Ort::Session session_{nullptr};
+    // the env and prepacked weights are shared by all detectors of the process,
+    // and the session by shared instances since Session::Run is thread-safe
+    std::shared_ptr<Ort::Env> env_;
+    std::shared_ptr<Ort::PrepackedWeightsContainer> prepacked_weights_;
+    std::shared_ptr<Ort::Session> session_;
     Ort::MemoryInfo memory_info_{nullptr};
     std::vector<std::string> input_names_, output_names_;
     std::vector<const char *> input_names_ptr_, output_names_ptr_;
+    // whether the model outputs final detections, see tools/add_nms_head.py
+    bool has_nms_head_ = false;
+
+    /**
+     * @brief run inference and postprocessing on a blob
+     * @param blob                      normalized RGB letterbox in NCHW layout
+     * @param img_rows, img_cols        original image size
+     * @param pad_rows, pad_cols        letterbox padding size
+     * @param scale                     letterbox scaling ratio
+     * @return vector of detected objects
+     */
+    std::vector<Object> Run(cv::Mat &blob, const int img_rows, const int img_cols,
+        const int pad_rows, const int pad_cols, const float scale);
 };
 
 }   // namespace Infer
@@ -4,6 +4,8 @@
 #include "detectors/base_detector.hpp"
 #include <string>
 #include <memory>
+#include <map>
+#include <array>
 
 #include <opencv2/opencv.hpp>
 #include <openvino/openvino.hpp>
@@ -14,19 +16,76 @@ namespace Infer
 class OVDetector : public BaseDetector
 {
 public:
-    OVDetector();
+    /**
+     * @param embed_preprocess  whether to fold resize, color conversion and normalization into the model,
+     *                          so that raw frames are fed without host preprocessing
+     */
+    explicit OVDetector(const bool embed_preprocess = false);
     ~OVDetector();
 
     std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
     bool Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class) override;
+    std::unique_ptr<BaseDetector> CreateSharedInstance() override;
+    bool SetTargetSize(const int target_size) override;
 
 private:
     ov::Core core_;
+    std::shared_ptr<ov::Model> model_ = nullptr;
     std::shared_ptr<ov::Model> net_ = nullptr;
+    // shared by shared instances, each creates its own infer request
     ov::CompiledModel compiled_model_;
     ov::InferRequest infer_request_;
+    // whether the model outputs final detections, see tools/add_nms_head.py
+    bool has_nms_head_ = false;
+
+    // model compiled with embedded preprocessing for one target size, frame size and format
+    struct EmbeddedModel
+    {
+        std::shared_ptr<ov::Model> net;
+        ov::CompiledModel compiled_model;
+        ov::InferRequest infer_request;
+        cv::Size input_size;    // model input size resized to by the embedded preprocessing
+    };
+    using EmbeddedKey = std::array<int, 4>;     // target size, frame rows, frame cols, pixel format
+
+    bool embed_preprocess_;
+    // every shape seen is kept, so that switching target sizes does not recompile in the frame path
+    std::map<EmbeddedKey, EmbeddedModel> embedded_models_;
+    EmbeddedKey embedded_key_ = {};             // key of the model in compiled_model_ and infer_request_
+    cv::Size input_size_;
+
+    /**
+     * @brief build and compile the model with embedded preprocessing for a frame size
+     * @param img_rows, img_cols    frame size
+     * @param format                pixel format of the frame, BGR or NV12
+     * @param embedded              compiled model
+     * @return whether compilation was successful
+     */
+    bool CompileEmbedded(const int img_rows, const int img_cols, const PixelFormat format, EmbeddedModel &embedded);
+
+    /**
+     * @brief detect objects in a raw frame with embedded preprocessing
+     * @param frame     frame to be detected
+     * @param format    pixel format of the frame, BGR or NV12
+     * @return vector of detected objects
+     */
+    std::vector<Object> DetectEmbedded(const cv::Mat &frame, const PixelFormat format);
+
+    /**
+     * @brief run inference and postprocessing
+     * @param input                     u8 input tensor data
+     * @param input_rows, input_cols    model input size
+     * @param img_rows, img_cols        original image size
+     * @param dh, dw                    padding size applied to the height and width
+     * @param ratio_h, ratio_w          scaling ratios applied to height and width
+     * @return vector of detected objects
+     */
+    std::vector<Object> Run(const cv::Mat &input, const int input_rows, const int input_cols,
+        const int img_rows, const int img_cols,
+        const float dh, const float dw, const float ratio_h, const float ratio_w);
 };
 
 }   // namespace Infer
@@ -0,0 +1,93 @@
+#ifndef PROPOSAL_ARENA_HPP_
+#define PROPOSAL_ARENA_HPP_
+
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+namespace Infer
+{
+
+// allocator for SIMD-friendly arrays
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T * allocate(size_t n)
+    {
+        void *ptr = ::operator new(n * sizeof(T), std::align_val_t(Alignment));
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, size_t)
+    {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// proposals in letterbox space stored as separate arrays, reused across frames to avoid reallocation
+struct ProposalArena
+{
+    AlignedVector<float> x0, y0, x1, y1;
+    AlignedVector<float> score;
+    AlignedVector<int> label;
+
+    size_t Size() const
+    {
+        return score.size();
+    }
+
+    void Clear()
+    {
+        x0.clear();
+        y0.clear();
+        x1.clear();
+        y1.clear();
+        score.clear();
+        label.clear();
+    }
+
+    void Push(const float box_x0, const float box_y0, const float box_x1, const float box_y1,
+        const float box_score, const int box_label)
+    {
+        x0.push_back(box_x0);
+        y0.push_back(box_y0);
+        x1.push_back(box_x1);
+        y1.push_back(box_y1);
+        score.push_back(box_score);
+        label.push_back(box_label);
+    }
+
+    void Append(const ProposalArena &other)
+    {
+        x0.insert(x0.end(), other.x0.begin(), other.x0.end());
+        y0.insert(y0.end(), other.y0.begin(), other.y0.end());
+        x1.insert(x1.end(), other.x1.begin(), other.x1.end());
+        y1.insert(y1.end(), other.y1.begin(), other.y1.end());
+        score.insert(score.end(), other.score.begin(), other.score.end());
+        label.insert(label.end(), other.label.begin(), other.label.end());
+    }
+};
+
+}   // namespace Infer
+
+#endif  // PROPOSAL_ARENA_HPP_
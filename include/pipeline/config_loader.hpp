@@ -0,0 +1,59 @@
+#ifndef CONFIG_LOADER_HPP_
+#define CONFIG_LOADER_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <opencv2/opencv.hpp>
+#include "json.hpp"
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+/**
+ * @brief get the model path of the selected framework
+ * @param config        parsed JSON config
+ * @param config_path   path of the config file, models are located relative to it
+ * @return model file path without file extension
+ */
+std::string GetModelPath(const nlohmann::json &config, const std::string &config_path);
+
+/**
+ * @brief get the thresholds, detection limits and class filter
+ * @param config        parsed JSON config
+ * @param settings      post-processing settings
+ * @return false if the class filter has an unknown label
+ */
+bool GetPostprocessSettings(const nlohmann::json &config, PostprocessSettings &settings);
+
+/**
+ * @brief create and initialize the detector of the selected framework,
+ *        wrapped in a DeadlineDetector if the Deadline section is enabled
+ * @param config        parsed JSON config
+ * @param model_path    model file path without file extension
+ * @return initialized detector, nullptr on failure
+ */
+std::unique_ptr<BaseDetector> CreateDetector(const nlohmann::json &config, const std::string &model_path);
+
+/**
+ * @brief create detectors for a pool, the model is loaded once and shared if the framework supports it
+ * @param config        parsed JSON config
+ * @param model_path    model file path without file extension
+ * @param count         number of detectors
+ * @return initialized detectors, empty on failure
+ */
+std::vector<std::unique_ptr<BaseDetector>> CreateDetectors(const nlohmann::json &config, const std::string &model_path,
+    const int count);
+
+/**
+ * @brief convert a JSON array of [x, y] points to a polygon
+ * @param points    JSON array of points
+ * @return polygon
+ */
+std::vector<cv::Point> ToPolygon(const nlohmann::json &points);
+
+}   // namespace Infer
+
+#endif  // CONFIG_LOADER_HPP_
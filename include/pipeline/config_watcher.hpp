@@ -0,0 +1,94 @@
+#ifndef CONFIG_WATCHER_HPP_
+#define CONFIG_WATCHER_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "json.hpp"
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+// config values that can change while running
+struct LiveSettings
+{
+    PostprocessSettings postprocess;
+    std::vector<std::string> labels;
+};
+
+// reads the live settings again whenever the config file changes, other sections are ignored,
+// each version is an immutable snapshot that consumers apply between detections
+class ConfigWatcher
+{
+public:
+    // called on the watcher thread with each new version
+    using Callback = std::function<void(std::shared_ptr<const LiveSettings>)>;
+
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    // disable copy and move since the thread refers to the watcher
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    ConfigWatcher & operator=(const ConfigWatcher &) = delete;
+    ConfigWatcher(ConfigWatcher &&) = delete;
+    ConfigWatcher & operator=(ConfigWatcher &&) = delete;
+
+    /**
+     * @param config_path   config file to watch
+     * @param config        parsed config the process started with, the first version
+     * @param watch         whether to watch the file, otherwise the first version is kept
+     * @param poll_ms       interval of checking the file
+     * @param on_change     called with each new version, may be empty
+     * @return false if the settings of the config are invalid
+     */
+    bool Start(const std::string &config_path, const nlohmann::json &config, const bool watch, const int poll_ms,
+        Callback on_change);
+    void Stop();
+
+    /**
+     * @brief get the latest valid settings, thread-safe
+     */
+    std::shared_ptr<const LiveSettings> Get() const;
+
+    /**
+     * @brief read the live settings of a config
+     * @param config    parsed config
+     * @param settings  live settings
+     * @return false if they are invalid
+     */
+    static bool Parse(const nlohmann::json &config, LiveSettings &settings);
+
+private:
+    std::string config_path_;
+    int poll_ms_ = 1000;
+    Callback on_change_;
+    std::shared_ptr<const LiveSettings> settings_;  // accessed with std::atomic_load and std::atomic_store
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+
+    void Run();
+
+    /**
+     * @brief parse the config file and publish the settings if they are valid and changed
+     */
+    void Reload();
+
+    /**
+     * @brief hash of the size and modification time of the config file
+     */
+    uint64_t GetFingerprint() const;
+};
+
+}   // namespace Infer
+
+#endif  // CONFIG_WATCHER_HPP_
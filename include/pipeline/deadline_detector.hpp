@@ -0,0 +1,105 @@
+#ifndef DEADLINE_DETECTOR_HPP_
+#define DEADLINE_DETECTOR_HPP_
+
+#include <array>
+#include <memory>
+#include <set>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+// degradation steps, each level includes the previous ones
+enum class DegradeLevel
+{
+    Full,               // configured threshold, target size and model
+    RaisedThreshold,    // fewer proposals reach NMS
+    ReducedSize,        // smaller letterbox
+    FallbackModel       // smaller model, if one is configured
+};
+
+const char * GetDegradeLevelName(const DegradeLevel level);
+
+class DeadlineDetector : public BaseDetector
+{
+public:
+    /**
+     * @param primary   initialized detector used at full quality
+     * @param fallback  initialized smaller detector for the last level, may be nullptr
+     */
+    DeadlineDetector(std::unique_ptr<BaseDetector> primary, std::unique_ptr<BaseDetector> fallback);
+    ~DeadlineDetector() = default;
+
+    /**
+     * @brief configure the latency budget and the degradation steps
+     * @param budget_ms             latency budget of Detect calls without an explicit budget
+     * @param raised_conf_thres     confidence threshold from DegradeLevel::RaisedThreshold on
+     * @param reduced_target_size   letterbox target size from DegradeLevel::ReducedSize on
+     * @param probe_interval        frames between attempts to recover one level, the attempt may miss the budget
+     */
+    void Configure(const double budget_ms, const float raised_conf_thres,
+        const int reduced_target_size, const int probe_interval);
+
+    std::vector<Object> Detect(const cv::Mat &bgr) override;
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format) override;
+
+    /**
+     * @brief detect at the least degraded level expected to finish within the budget
+     * @param frame         frame to be detected
+     * @param format        pixel format of the frame
+     * @param budget_ms     latency budget
+     * @param level         level that was used
+     * @return vector of detected objects
+     */
+    std::vector<Object> Detect(const cv::Mat &frame, const PixelFormat format,
+        const double budget_ms, DegradeLevel &level);
+
+    /**
+     * @brief initialize the primary detector, the fallback is initialized by the caller
+     */
+    bool Initialize(const int threads, const std::string &model_path,
+        const float conf_thres, const float nms_thres,
+        const int target_size, const int max_stride, const int num_class) override;
+    std::unique_ptr<BaseDetector> CreateSharedInstance() override;
+    bool SetTargetSize(const int target_size) override;
+
+    /**
+     * @brief apply to both models, the raised threshold of the degraded levels is kept
+     */
+    void SetPostprocessSettings(const PostprocessSettings &settings) override;
+
+    DegradeLevel GetLastLevel() const;
+    double GetLastLatency() const;
+
+private:
+    static constexpr int kNumLevels = 4;
+
+    std::unique_ptr<BaseDetector> primary_;
+    std::unique_ptr<BaseDetector> fallback_;
+    float fallback_conf_thres_ = 0.0f;
+    int fallback_target_size_ = 0;
+
+    double budget_ms_ = 0.0;
+    float raised_conf_thres_ = 0.0f;
+    int reduced_target_size_ = 0;
+    int probe_interval_ = 30;
+
+    std::array<double, kNumLevels> estimates_ms_ = {};  // smoothed latency of each level, 0 if unknown
+    std::set<std::array<int, 5>> seen_shapes_;          // level, target size, image rows, cols and pixel format
+    int frames_degraded_ = 0;
+    DegradeLevel last_level_ = DegradeLevel::Full;
+    double last_latency_ms_ = 0.0;
+
+    /**
+     * @brief select the least degraded level expected to finish within the budget
+     * @param budget_ms     latency budget
+     * @return selected level
+     */
+    DegradeLevel SelectLevel(const double budget_ms);
+};
+
+}   // namespace Infer
+
+#endif  // DEADLINE_DETECTOR_HPP_
@@ -0,0 +1,94 @@
+#ifndef DETECT_SERVICE_HPP_
+#define DETECT_SERVICE_HPP_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <chrono>
+
+#include <opencv2/opencv.hpp>
+#include "pipeline/detector_pool.hpp"
+
+namespace Infer
+{
+
+struct DetectJob
+{
+    std::string encoded;                    // JPEG/PNG bytes, decoded by the worker, or empty if frame is set
+    cv::Mat frame;                          // raw frame
+    PixelFormat format = PixelFormat::BGR;  // pixel format of the raw frame
+};
+
+struct DetectResult
+{
+    bool ok = false;            // false if the image could not be decoded
+    std::vector<Object> objects;
+    int img_rows = 0, img_cols = 0;
+    double queue_ms = 0.0;      // time spent waiting for a worker
+    double elapsed_ms = 0.0;    // decoding and detection time
+};
+
+// bounded job queue served by one worker per pooled detector, each idle worker takes one job,
+// when no worker is idle the backlog is taken in batches so that a worker leases its detector once per batch
+class DetectService
+{
+public:
+    /**
+     * @param pool              initialized detectors
+     * @param max_queue         queued jobs beyond this are rejected
+     * @param max_batch         maximum jobs taken at once while no other worker is idle
+     */
+    DetectService(DetectorPool &pool, const size_t max_queue, const int max_batch);
+    ~DetectService();
+
+    // disable copy and move since worker threads refer to the service
+    DetectService(const DetectService &) = delete;
+    DetectService & operator=(const DetectService &) = delete;
+    DetectService(DetectService &&) = delete;
+    DetectService & operator=(DetectService &&) = delete;
+
+    void Start();
+    void Stop();
+
+    /**
+     * @brief queue a job
+     * @param job       job to be detected
+     * @param result    future of the result
+     * @return false if the queue is full or the service is stopped, the caller should retry later
+     */
+    bool Submit(DetectJob job, std::future<DetectResult> &result);
+
+    size_t GetQueueSize() const;
+    uint64_t GetRejectedCount() const;
+
+private:
+    struct PendingJob
+    {
+        DetectJob job;
+        std::promise<DetectResult> promise;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    DetectorPool &pool_;
+    size_t max_queue_;
+    size_t max_batch_;
+    size_t idle_ = 0;       // workers waiting for jobs
+
+    std::deque<PendingJob> queue_;
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::atomic<uint64_t> rejected_{0};
+
+    void WorkerLoop();
+};
+
+}   // namespace Infer
+
+#endif  // DETECT_SERVICE_HPP_
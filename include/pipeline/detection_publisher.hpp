@@ -0,0 +1,88 @@
+#ifndef DETECTION_PUBLISHER_HPP_
+#define DETECTION_PUBLISHER_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+/**
+ * Detection record on the stream, little-endian:
+ *   uint32 length          bytes following this field
+ *   uint64 frame_id
+ *   int64  timestamp_us    capture time since the Unix epoch
+ *   uint32 count
+ *   count x { int32 label, float32 prob, float32 x, y, width, height }
+ */
+constexpr size_t kDetectionRecordHeader = 4 + 8 + 8 + 4;
+constexpr size_t kDetectionObjectSize = 4 + 5 * 4;
+
+/**
+ * @brief append one encoded record to a buffer
+ */
+void EncodeDetections(const uint64_t frame_id, const int64_t timestamp_us,
+    const std::vector<Object> &objects, std::string &buffer);
+
+// streams detection records to clients subscribed on a Unix domain socket, never blocks the caller:
+// records that do not fit into a slow client's pending buffer are dropped for that client
+class DetectionPublisher
+{
+public:
+    DetectionPublisher() = default;
+    ~DetectionPublisher();
+
+    // disable copy since the sockets are owned
+    DetectionPublisher(const DetectionPublisher &) = delete;
+    DetectionPublisher & operator=(const DetectionPublisher &) = delete;
+
+    /**
+     * @brief listen on a socket path, a stale socket file is replaced
+     * @param path              socket path
+     * @param max_pending_bytes pending bytes per client before records are dropped
+     * @return whether the socket is listening
+     */
+    bool Open(const std::string &path, const size_t max_pending_bytes);
+    void Close();
+
+    /**
+     * @brief accept new subscribers and send a record to all of them
+     * @param frame_id      frame id
+     * @param timestamp_us  capture time since the Unix epoch
+     * @param objects       detected objects
+     */
+    void Publish(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects);
+
+    size_t GetClientCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct Client
+    {
+        int fd;
+        std::string pending;    // bytes not sent yet, always ends at a record boundary
+    };
+
+    std::string path_;
+    int listen_fd_ = -1;
+    size_t max_pending_bytes_ = 0;
+    std::vector<Client> clients_;
+    std::string record_;
+    uint64_t dropped_ = 0;
+
+    void Accept();
+
+    /**
+     * @brief send as much of the pending bytes as the socket takes
+     * @return false if the client disconnected
+     */
+    static bool Flush(Client &client);
+};
+
+}   // namespace Infer
+
+#endif  // DETECTION_PUBLISHER_HPP_
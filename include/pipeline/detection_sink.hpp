@@ -0,0 +1,88 @@
+#ifndef DETECTION_SINK_HPP_
+#define DETECTION_SINK_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+#include "pipeline/result_log.hpp"
+
+namespace Infer
+{
+
+// destination of the results of each detected frame
+class DetectionSink
+{
+public:
+    virtual ~DetectionSink() = default;
+
+    /**
+     * @param frame_id      frame id
+     * @param timestamp_us  capture time since the Unix epoch
+     * @param objects       detected objects
+     */
+    virtual void Write(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects) = 0;
+
+    /**
+     * @brief change the label names, for sinks that write them
+     */
+    virtual void SetLabels(const std::vector<std::string> & /*labels*/) {}
+};
+
+// one JSON object per frame and line, the same layout as convert_results
+class JsonLinesSink : public DetectionSink
+{
+public:
+    /**
+     * @param file      output file
+     * @param owned     whether the sink closes the file
+     * @param flush     flush after every line, for consumers reading a pipe
+     * @param labels    label names
+     */
+    JsonLinesSink(std::FILE *file, const bool owned, const bool flush, const std::vector<std::string> &labels);
+    ~JsonLinesSink();
+
+    void Write(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects) override;
+    void SetLabels(const std::vector<std::string> &labels) override;
+
+private:
+    std::FILE *file_;
+    bool owned_;
+    bool flush_;
+    std::vector<std::string> labels_;   // JSON-escaped
+};
+
+class ResultLogSink : public DetectionSink
+{
+public:
+    /**
+     * @param path  binary result log path
+     * @return whether the log was opened
+     */
+    bool Open(const std::string &path);
+
+    void Write(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects) override;
+
+private:
+    ResultLogWriter writer_;
+};
+
+/**
+ * @brief create a sink, stdout makes the sink the only writer of the standard output and
+ *        sends everything else printed afterwards to standard error
+ * @param type      none, stdout, jsonl or log
+ * @param path      output path of jsonl and log
+ * @param labels    label names
+ * @param sink      created sink, nullptr for none
+ * @return false if the type is unknown or the output cannot be opened
+ */
+bool CreateDetectionSink(const std::string &type, const std::string &path,
+    const std::vector<std::string> &labels, std::unique_ptr<DetectionSink> &sink);
+
+}   // namespace Infer
+
+#endif  // DETECTION_SINK_HPP_
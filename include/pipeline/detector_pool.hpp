@@ -0,0 +1,101 @@
+#ifndef DETECTOR_POOL_HPP_
+#define DETECTOR_POOL_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+class DetectorPool
+{
+public:
+    // exclusive use of one detector, returned to the pool on destruction
+    class Lease
+    {
+    public:
+        Lease(DetectorPool *pool, BaseDetector *detector, const uint64_t generation);
+        ~Lease();
+
+        Lease(const Lease &) = delete;
+        Lease & operator=(const Lease &) = delete;
+        Lease(Lease &&other) noexcept;
+        Lease & operator=(Lease &&) = delete;
+
+        BaseDetector & operator*() const;
+        BaseDetector * operator->() const;
+
+    private:
+        DetectorPool *pool_;
+        BaseDetector *detector_;
+        uint64_t generation_;
+    };
+
+    DetectorPool() = default;
+    ~DetectorPool() = default;
+
+    // disable copy and move since leases refer to the pool
+    DetectorPool(const DetectorPool &) = delete;
+    DetectorPool & operator=(const DetectorPool &) = delete;
+    DetectorPool(DetectorPool &&) = delete;
+    DetectorPool & operator=(DetectorPool &&) = delete;
+
+    /**
+     * @brief add an initialized detector to the pool
+     * @param detector  detector to be shared
+     */
+    void Add(std::unique_ptr<BaseDetector> detector);
+
+    /**
+     * @brief get the number of detectors
+     */
+    size_t Size() const;
+
+    /**
+     * @brief wait until a detector is free and lease it
+     * @return lease of the detector
+     */
+    Lease Acquire();
+
+    /**
+     * @brief swap in new detectors, e.g. of a reloaded model, new leases get them immediately
+     *        and the call returns after the old detectors are released and destroyed
+     * @param detectors     initialized detectors replacing the current ones
+     */
+    void Replace(std::vector<std::unique_ptr<BaseDetector>> detectors);
+
+    /**
+     * @brief change all detectors between detections, free detectors now and leased ones when returned
+     * @param update    applied once to each detector, also to detectors added later, replaces earlier updates
+     */
+    void Update(std::function<void(BaseDetector &)> update);
+
+private:
+    std::vector<std::unique_ptr<BaseDetector>> detectors_;
+    std::vector<BaseDetector *> free_;
+    uint64_t generation_ = 0;       // incremented by Replace, leases of older generations are not returned
+    size_t retired_leases_ = 0;     // leases of older generations still in use
+    std::function<void(BaseDetector &)> update_;
+    uint64_t update_version_ = 0;
+    std::unordered_map<BaseDetector *, uint64_t> applied_;  // update version applied to each detector
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+
+    void Release(BaseDetector *detector, const uint64_t generation);
+
+    /**
+     * @brief apply the latest update if the detector does not have it, called with the mutex held
+     */
+    void ApplyUpdate(BaseDetector *detector);
+};
+
+}   // namespace Infer
+
+#endif  // DETECTOR_POOL_HPP_
@@ -0,0 +1,106 @@
+#ifndef HTTP_SERVER_HPP_
+#define HTTP_SERVER_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+namespace Infer
+{
+
+struct HttpRequest
+{
+    std::string method;
+    std::string version;
+    std::string path;                               // without the query string
+    std::map<std::string, std::string> query;
+    std::map<std::string, std::string> headers;     // lowercase names
+    std::string body;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    std::string content_type = "application/json";
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+};
+
+// minimal HTTP/1.1 server for local clients: one thread per connection, keep-alive,
+// Content-Length bodies only (no chunked transfer encoding)
+class HttpServer
+{
+public:
+    /**
+     * @brief called from the connection thread for each complete request
+     */
+    using Handler = std::function<void(const HttpRequest &request, HttpResponse &response)>;
+
+    HttpServer() = default;
+    ~HttpServer();
+
+    // disable copy and move since connection threads refer to the server
+    HttpServer(const HttpServer &) = delete;
+    HttpServer & operator=(const HttpServer &) = delete;
+    HttpServer(HttpServer &&) = delete;
+    HttpServer & operator=(HttpServer &&) = delete;
+
+    /**
+     * @brief listen and start accepting connections
+     * @param host              address to bind, e.g. 127.0.0.1
+     * @param port              port to bind
+     * @param max_connections   connections beyond this are answered with 503 and closed
+     * @param max_body_size     larger request bodies are answered with 413
+     * @param handler           request handler
+     * @return whether the server is listening
+     */
+    bool Start(const std::string &host, const int port, const int max_connections,
+        const size_t max_body_size, Handler handler);
+
+    /**
+     * @brief stop accepting, close all connections and wait for their threads
+     */
+    void Stop();
+
+private:
+    struct Connection
+    {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    int listen_fd_ = -1;
+    int max_connections_ = 64;
+    size_t max_body_size_ = 0;
+    Handler handler_;
+
+    std::atomic<bool> running_{false};
+    std::thread accept_thread_;
+    std::mutex mutex_;
+    std::list<Connection> connections_;
+
+    void AcceptLoop();
+    void ServeConnection(Connection &connection);
+
+    /**
+     * @brief read one request, bytes after it are kept in the buffer for the next request
+     * @param fd        connection socket
+     * @param buffer    bytes received but not consumed yet
+     * @param request   parsed request
+     * @param status    error status to answer with if the request is malformed, 0 if the connection was closed
+     * @return whether a complete request was read
+     */
+    bool ReadRequest(const int fd, std::string &buffer, HttpRequest &request, int &status);
+
+    static bool SendResponse(const int fd, const HttpResponse &response, const bool keep_alive);
+};
+
+}   // namespace Infer
+
+#endif  // HTTP_SERVER_HPP_
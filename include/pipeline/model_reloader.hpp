@@ -0,0 +1,90 @@
+#ifndef MODEL_RELOADER_HPP_
+#define MODEL_RELOADER_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+// loads a new model in the background when the model files change or a reload is requested,
+// warms it up and hands it over, the running detectors keep working until then
+class ModelReloader
+{
+public:
+    // creates the new detectors, empty on failure
+    using Factory = std::function<std::vector<std::unique_ptr<BaseDetector>>()>;
+    // runs a detection on a new detector the way the caller does, with its frame size, pixel format and crop
+    using Warmup = std::function<void(BaseDetector &)>;
+    // swaps in the warmed-up detectors
+    using Install = std::function<void(std::vector<std::unique_ptr<BaseDetector>>)>;
+
+    ModelReloader() = default;
+    ~ModelReloader();
+
+    // disable copy and move since the thread refers to the reloader
+    ModelReloader(const ModelReloader &) = delete;
+    ModelReloader & operator=(const ModelReloader &) = delete;
+    ModelReloader(ModelReloader &&) = delete;
+    ModelReloader & operator=(ModelReloader &&) = delete;
+
+    /**
+     * @param model_path    model file path without file extension, files starting with it are watched
+     * @param watch_files   whether to reload on file changes, otherwise only on request
+     * @param poll_ms       interval of checking files and requests
+     * @param factory       creates the new detectors
+     * @param warmup        called once with each new detector before it is installed
+     * @param install       swaps in the new detectors
+     */
+    void Start(const std::string &model_path, const bool watch_files, const int poll_ms,
+        Factory factory, Warmup warmup, Install install);
+    void Stop();
+
+    /**
+     * @brief reload at the next poll, safe to call from a signal handler
+     */
+    void RequestReload();
+
+    int GetReloadCount() const;
+
+private:
+    std::string model_path_;
+    bool watch_files_ = false;
+    int poll_ms_ = 1000;
+    Factory factory_;
+    Warmup warmup_;
+    Install install_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::atomic<bool> reload_requested_{false};
+    std::atomic<int> reload_count_{0};
+
+    void Run();
+
+    /**
+     * @brief load, warm up and install the new detectors
+     * @return whether the model was replaced
+     */
+    bool Reload();
+
+    /**
+     * @brief hash of the names, sizes and modification times of the model files
+     */
+    uint64_t GetFingerprint() const;
+};
+
+}   // namespace Infer
+
+#endif  // MODEL_RELOADER_HPP_
@@ -0,0 +1,53 @@
+#ifndef MOTION_GATE_HPP_
+#define MOTION_GATE_HPP_
+
+#include <opencv2/opencv.hpp>
+#include "pixel_format.hpp"
+
+namespace Infer
+{
+
+class MotionGate
+{
+public:
+    MotionGate() = default;
+    ~MotionGate() = default;
+
+    /**
+     * @brief configure the gate
+     * @param enable            whether to gate inference, a disabled gate lets every frame pass
+     * @param width             width of the downscaled grayscale frame used for differencing
+     * @param pixel_thres       minimum gray level change of a pixel to count as changed
+     * @param min_changed_ratio minimum ratio of changed pixels to let a frame pass
+     * @param max_skip_frames   maximum number of consecutive skipped frames, 0 for no limit
+     */
+    void Configure(bool enable, int width, int pixel_thres, float min_changed_ratio, int max_skip_frames);
+
+    /**
+     * @brief compare a frame with the last frame that passed the gate
+     * @param frame     frame to be compared
+     * @param format    pixel format of the frame
+     * @return whether the frame changed and should be detected
+     */
+    bool Update(const cv::Mat &frame, const PixelFormat format = PixelFormat::BGR);
+
+    /**
+     * @brief forget the reference frame so that the next frame passes
+     */
+    void Reset();
+
+private:
+    bool enable_ = false;
+    int width_ = 160;
+    int pixel_thres_ = 25;
+    float min_changed_ratio_ = 0.002f;
+    int max_skip_frames_ = 0;
+
+    int skipped_ = 0;
+    cv::Mat reference_;     // downscaled gray frame that last passed the gate
+    cv::Mat small_, gray_, diff_;
+};
+
+}   // namespace Infer
+
+#endif  // MOTION_GATE_HPP_
@@ -0,0 +1,66 @@
+#ifndef OBJECT_RENDERER_HPP_
+#define OBJECT_RENDERER_HPP_
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+// draws detections like BaseDetector::DrawObjects, but label text is rasterized once per class and
+// probability percent and copied afterwards, and boxes are filled directly instead of using cv::rectangle
+class ObjectRenderer
+{
+public:
+    /**
+     * @param labels        class names
+     * @param decimation    display is downscaled by this factor, for previews
+     */
+    explicit ObjectRenderer(const std::vector<std::string> &labels, const int decimation = 1);
+    ~ObjectRenderer() = default;
+
+    int GetDecimation() const;
+
+    /**
+     * @brief change the class names, cached labels are rasterized again
+     */
+    void SetLabels(const std::vector<std::string> &labels);
+
+    /**
+     * @brief get the display image of a BGR frame, shares the frame data without decimation
+     * @param bgr       frame to be displayed
+     * @param display   display image
+     */
+    void Prepare(const cv::Mat &bgr, cv::Mat &display) const;
+
+    /**
+     * @brief draw objects on a display image
+     * @param display   image returned by Prepare
+     * @param objects   detected objects in frame coordinates
+     */
+    void Draw(cv::Mat &display, const std::vector<Object> &objects);
+
+private:
+    static constexpr int kProbBuckets = 101;    // one label sprite per percent
+
+    std::vector<std::string> labels_;
+    std::vector<cv::Mat> sprites_;              // labels_.size() * kProbBuckets, rasterized on first use
+    int decimation_;
+
+    /**
+     * @brief get the label sprite of a class and probability
+     */
+    const cv::Mat & GetSprite(const int label, const float prob);
+
+    /**
+     * @brief fill a rectangle clipped to the image
+     */
+    static void FillRect(cv::Mat &image, int x0, int y0, int x1, int y1, const cv::Vec3b &color);
+};
+
+}   // namespace Infer
+
+#endif  // OBJECT_RENDERER_HPP_
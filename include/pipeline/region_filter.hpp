@@ -0,0 +1,79 @@
+#ifndef REGION_FILTER_HPP_
+#define REGION_FILTER_HPP_
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+class RegionFilter
+{
+public:
+    RegionFilter() = default;
+    ~RegionFilter() = default;
+
+    /**
+     * @brief set the region of interest and exclusion masks
+     * @param roi           polygon of the region of interest, empty for the whole frame
+     * @param exclusions    polygons where detections are dropped
+     * @param scale         factor frames are downscaled by from the coordinates of the polygons
+     */
+    void SetRegions(const std::vector<cv::Point> &roi, const std::vector<std::vector<cv::Point>> &exclusions,
+        const int scale = 1);
+
+    /**
+     * @brief whether any region is set
+     */
+    bool IsEnabled() const;
+
+    /**
+     * @brief detect objects only in the bounding box of the region of interest
+     * @param detector  detector to run on the cropped frame
+     * @param frame     frame to be detected
+     * @param format    pixel format of the frame
+     * @return detected objects inside the region of interest and outside the exclusion masks,
+     *         in frame coordinates
+     */
+    std::vector<Object> Detect(BaseDetector &detector, const cv::Mat &frame,
+        const PixelFormat format = PixelFormat::BGR) const;
+
+    /**
+     * @brief draw region outlines for preview
+     * @param image         BGR image to draw
+     * @param decimation    factor the image is downscaled by from the frame
+     */
+    void DrawRegions(cv::Mat &image, const int decimation = 1) const;
+
+private:
+    std::vector<cv::Point> roi_;
+    std::vector<std::vector<cv::Point>> exclusions_;
+    cv::Rect bounds_;
+
+    /**
+     * @brief get the crop rectangle aligned for the chroma subsampling of the pixel format
+     * @param img_rows, img_cols    frame size
+     * @param format                pixel format of the frame
+     * @return crop rectangle inside the frame
+     */
+    cv::Rect GetCropRect(const int img_rows, const int img_cols, const PixelFormat format) const;
+
+    /**
+     * @brief whether an object lies inside the region of interest and outside the exclusion masks
+     * @param obj   object in frame coordinates
+     */
+    bool IsInside(const Object &obj) const;
+};
+
+/**
+ * @brief scale object boxes, e.g. from downscaled frames back to capture coordinates
+ * @param objects   objects to be scaled
+ * @param scale     scaling factor
+ */
+void ScaleObjects(std::vector<Object> &objects, const float scale);
+
+}   // namespace Infer
+
+#endif  // REGION_FILTER_HPP_
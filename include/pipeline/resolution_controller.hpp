@@ -0,0 +1,81 @@
+#ifndef RESOLUTION_CONTROLLER_HPP_
+#define RESOLUTION_CONTROLLER_HPP_
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+class ResolutionController
+{
+public:
+    ResolutionController() = default;
+    ~ResolutionController() = default;
+
+    /**
+     * @brief configure the controller
+     * @param sizes                 candidate letterbox target sizes
+     * @param target_fps            detection rate to sustain
+     * @param min_object_pixels     minimum short side in letterbox pixels of the smallest recent object
+     * @param hold_frames           consecutive frames a new size must be preferred before switching
+     * @param window                number of recent frames whose objects are considered
+     */
+    void Configure(const std::vector<int> &sizes, const double target_fps,
+        const int min_object_pixels, const int hold_frames, const int window);
+
+    /**
+     * @brief run the detector once at every size so that shape-dependent plans, sessions and compiled models
+     *        are created before switching, sizes the detector does not support are dropped,
+     *        and the detector is left at the largest size
+     * @param detector      detector to be warmed up
+     * @param detect        runs one detection like the stream does, with its frame size, pixel format and crop
+     * @return initial target size, 0 if no size is supported
+     */
+    int Prewarm(BaseDetector &detector, const std::function<void(BaseDetector &)> &detect);
+
+    /**
+     * @brief update with the result of a detected frame
+     * @param latency_ms            detection latency of the frame
+     * @param objects               detected objects
+     * @param img_rows, img_cols    size of the detected image
+     * @return target size for the next frame
+     */
+    int Update(const double latency_ms, const std::vector<Object> &objects,
+        const int img_rows, const int img_cols);
+
+    int GetTargetSize() const;
+    /**
+     * @brief get the candidate sizes, only those supported by the detector after Prewarm
+     */
+    const std::vector<int> & GetSizes() const;
+
+private:
+    static constexpr float kNoObjects = 2.0f;     // entry of smallest_ for a frame without objects
+
+    std::vector<int> sizes_ = {320, 416, 512, 640};
+    double budget_ms_ = 1000.0 / 30.0;
+    int min_object_pixels_ = 32;
+    int hold_frames_ = 15;
+    int window_ = 30;
+
+    int current_ = 0;               // index in sizes_
+    double latency_ms_ = 0.0;       // smoothed latency at the current size
+    std::deque<float> smallest_;    // short side of the smallest object of recent frames, relative to the image,
+                                    // kNoObjects for frames without objects
+    int candidate_ = -1;            // size index preferred over the current one
+    int candidate_frames_ = 0;
+
+    /**
+     * @brief get the size index that fits the latency budget and still resolves the smallest recent object
+     */
+    int SelectSize() const;
+};
+
+}   // namespace Infer
+
+#endif  // RESOLUTION_CONTROLLER_HPP_
@@ -0,0 +1,115 @@
+#ifndef RESULT_LOG_HPP_
+#define RESULT_LOG_HPP_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+#include "detectors/mapped_file.hpp"
+
+namespace Infer
+{
+
+/**
+ * Append-only binary log of detections, one row per object, little-endian:
+ *   file header    char[4] "YRES", uint32 version
+ *   chunks         uint32 rows, uint32 reserved, then the columns of all rows one after another:
+ *                  uint64 frame_id, int64 timestamp_us, float32 prob, x, y, width, height,
+ *                  int32 label, uint16 stream, padded to 8 bytes
+ * Frames without objects are stored as one row with label -1 so that every frame appears in the log.
+ * A chunk is written at once, so a log cut short by a crash loses at most the last chunk.
+ */
+class ResultLogWriter
+{
+public:
+    ResultLogWriter() = default;
+    ~ResultLogWriter();
+
+    // disable copy since the file is owned
+    ResultLogWriter(const ResultLogWriter &) = delete;
+    ResultLogWriter & operator=(const ResultLogWriter &) = delete;
+
+    /**
+     * @brief create a log file or append to an existing one, an incomplete last chunk is dropped
+     * @param path          log file path
+     * @param chunk_rows    rows buffered before a chunk is written
+     * @return whether the file was opened
+     */
+    bool Open(const std::string &path, const size_t chunk_rows = 65536);
+
+    /**
+     * @brief write the buffered rows and close the file
+     */
+    void Close();
+
+    /**
+     * @brief append the results of a frame, thread-safe
+     * @param frame_id      frame id
+     * @param timestamp_us  capture time since the Unix epoch
+     * @param objects       detected objects
+     * @param stream        stream index
+     */
+    void Append(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects,
+        const uint16_t stream = 0);
+
+private:
+    std::FILE *file_ = nullptr;
+    size_t chunk_rows_ = 65536;
+    std::mutex mutex_;
+
+    std::vector<uint64_t> frame_id_;
+    std::vector<int64_t> timestamp_us_;
+    std::vector<float> prob_, x_, y_, width_, height_;
+    std::vector<int32_t> label_;
+    std::vector<uint16_t> stream_;
+
+    void AppendRow(const uint64_t frame_id, const int64_t timestamp_us, const int32_t label,
+        const float prob, const cv::Rect_<float> &rect, const uint16_t stream);
+    void WriteChunk();
+};
+
+// column pointers of a chunk, pointing into the mapped file
+struct ResultChunk
+{
+    size_t rows = 0;
+    const uint64_t *frame_id = nullptr;
+    const int64_t *timestamp_us = nullptr;
+    const float *prob = nullptr;
+    const float *x = nullptr;
+    const float *y = nullptr;
+    const float *width = nullptr;
+    const float *height = nullptr;
+    const int32_t *label = nullptr;
+    const uint16_t *stream = nullptr;
+};
+
+class ResultLogReader
+{
+public:
+    ResultLogReader() = default;
+    ~ResultLogReader() = default;
+
+    /**
+     * @brief map a log file and index its chunks, an incomplete last chunk is ignored
+     * @param path  log file path
+     * @return whether the file is a result log
+     */
+    bool Open(const std::string &path);
+
+    size_t GetChunkCount() const;
+    const ResultChunk & GetChunk(const size_t index) const;
+    size_t GetRowCount() const;
+
+private:
+    MappedFile file_;
+    std::vector<ResultChunk> chunks_;
+    size_t rows_ = 0;
+};
+
+}   // namespace Infer
+
+#endif  // RESULT_LOG_HPP_
@@ -0,0 +1,151 @@
+#ifndef SHM_RING_HPP_
+#define SHM_RING_HPP_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+#include "detectors/base_detector.hpp"
+
+namespace Infer
+{
+
+// detection record written back into a slot
+struct ShmObject
+{
+    int32_t label;
+    float prob;
+    float x, y, width, height;
+};
+
+// ring of frame slots in POSIX shared memory, signaled with futexes (Linux only).
+// Producers write frames directly into a slot and detector processes read them in place,
+// results are written back into the same slot and the slot is freed once the producer read them.
+class ShmRing
+{
+public:
+    ShmRing() = default;
+    ~ShmRing();
+
+    // disable copy since the mapping is owned
+    ShmRing(const ShmRing &) = delete;
+    ShmRing & operator=(const ShmRing &) = delete;
+
+    /**
+     * @brief create the shared memory object, replacing a stale one with the same name
+     * @param name              shared memory name, e.g. /yolov5_frames
+     * @param slot_count        number of frame slots
+     * @param max_frame_bytes   maximum frame size in bytes
+     * @param max_objects       maximum results per frame
+     * @return whether the ring was created
+     */
+    bool Create(const std::string &name, const int slot_count, const size_t max_frame_bytes, const int max_objects);
+
+    /**
+     * @brief attach to a ring created by another process
+     * @param name      shared memory name
+     * @return whether the ring was attached
+     */
+    bool Open(const std::string &name);
+
+    /**
+     * @brief unmap the ring, the creator also removes the name
+     */
+    void Close();
+
+    int GetSlotCount() const;
+    size_t GetMaxFrameBytes() const;
+
+    // --- producer side
+
+    /**
+     * @brief wait for a free slot and reserve it, slots left behind by crashed processes are reclaimed
+     * @param timeout_ms    maximum wait, negative to wait forever
+     * @return slot index, -1 on timeout
+     */
+    int AcquireSlot(const int timeout_ms);
+
+    /**
+     * @brief get the frame buffer of a reserved slot, GetMaxFrameBytes bytes, 64-byte aligned
+     */
+    uint8_t * GetFrameData(const int slot);
+
+    /**
+     * @brief hand a written frame to the detector processes
+     * @param slot          reserved slot
+     * @param frame_id      caller-defined frame id, returned with the results
+     * @param width         frame width
+     * @param height        frame height, not including the NV12 chroma rows
+     * @param format        pixel format of the frame
+     * @return false if the frame does not fit into the slot
+     */
+    bool PublishFrame(const int slot, const uint64_t frame_id, const int width, const int height, const PixelFormat format);
+
+    /**
+     * @brief wait for the results of a published slot, read them and free the slot
+     * @param slot          published slot
+     * @param objects       detected objects
+     * @param timeout_ms    maximum wait, negative to wait forever
+     * @return false on timeout, the slot stays owned by the producer, wait again or give it up with CancelSlot
+     */
+    bool WaitResult(const int slot, std::vector<Object> &objects, const int timeout_ms);
+
+    /**
+     * @brief give up a reserved or published slot, e.g. after WaitResult timed out,
+     *        a slot being detected is freed once the detector is done with it
+     * @param slot          reserved or published slot
+     */
+    void CancelSlot(const int slot);
+
+    // --- detector side
+
+    /**
+     * @brief wait for a published frame and take it
+     * @param timeout_ms    maximum wait, negative to wait forever
+     * @return slot index, -1 on timeout
+     */
+    int WaitFrame(const int timeout_ms);
+
+    /**
+     * @brief wrap the frame of a taken slot without copying
+     * @param slot          taken slot
+     * @param format        pixel format of the frame
+     * @param frame_id      frame id given by the producer
+     * @return frame referring to the shared memory, valid until PublishResult,
+     *         empty if the size or format written by the producer is invalid
+     */
+    cv::Mat GetFrame(const int slot, PixelFormat &format, uint64_t &frame_id);
+
+    /**
+     * @brief write the results into a taken slot and wake the producer
+     * @param slot      taken slot
+     * @param objects   detected objects, truncated to the maximum results per frame
+     */
+    void PublishResult(const int slot, const std::vector<Object> &objects);
+
+private:
+    struct Header;
+    struct Slot;
+
+    std::string name_;
+    bool owner_ = false;
+    uint8_t *base_ = nullptr;
+    size_t size_ = 0;
+    Header *header_ = nullptr;
+    std::atomic<uint32_t> cursor_{0};   // next slot to look at, shared by threads using this mapping
+
+    Slot * GetSlot(const int slot) const;
+    /**
+     * @brief free the slots of crashed producers, and hand frames taken by crashed detectors to the others
+     * @return whether any slot was freed
+     */
+    bool ReclaimSlots();
+    ShmObject * GetObjects(const int slot) const;
+    bool Map(const int fd, const size_t size);
+};
+
+}   // namespace Infer
+
+#endif  // SHM_RING_HPP_
@@ -0,0 +1,105 @@
+#ifndef STREAM_RUNNER_HPP_
+#define STREAM_RUNNER_HPP_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "pipeline/detector_pool.hpp"
+#include "pipeline/stream_source.hpp"
+#include "pipeline/stream_scheduler.hpp"
+
+namespace Infer
+{
+
+struct StreamStats
+{
+    std::string name;
+    uint64_t captured = 0;      // frames read from the source
+    uint64_t dropped = 0;       // frames replaced by a newer frame before being scheduled
+    uint64_t detected = 0;      // frames passed to a detector
+    uint64_t skipped = 0;       // frames skipped by the motion gate
+    double capture_fps = 0.0;   // since the previous GetStats call
+    double detect_fps = 0.0;
+};
+
+class MultiStreamRunner
+{
+public:
+    /**
+     * @brief called from a worker thread after each scheduled frame,
+     *        different streams may be reported concurrently but a stream is never reported twice at once
+     * @param stream    index of the stream
+     * @param frame     scheduled frame
+     * @param objects   detected objects, or the last results if the motion gate skipped the frame
+     */
+    using Callback = std::function<void(size_t stream, const StreamFrame &frame, const std::vector<Object> &objects)>;
+
+    /**
+     * @param pool          detectors shared by all streams, one worker thread is started per detector
+     * @param policy        schedule policy
+     * @param deadline_ms   latency budget of a weight 1 stream for the deadline policy
+     */
+    MultiStreamRunner(DetectorPool &pool, const SchedulePolicy policy, const int deadline_ms);
+    ~MultiStreamRunner();
+
+    // disable copy and move since worker threads refer to the runner
+    MultiStreamRunner(const MultiStreamRunner &) = delete;
+    MultiStreamRunner & operator=(const MultiStreamRunner &) = delete;
+    MultiStreamRunner(MultiStreamRunner &&) = delete;
+    MultiStreamRunner & operator=(MultiStreamRunner &&) = delete;
+
+    /**
+     * @brief add an opened stream, must be called before Start
+     * @param source    opened stream
+     * @return index of the stream
+     */
+    size_t AddStream(std::unique_ptr<StreamSource> source);
+    size_t GetStreamCount() const;
+
+    void Start(Callback callback);
+    void Stop();
+
+    /**
+     * @brief whether all streams ended and their last frames were processed
+     */
+    bool IsFinished() const;
+
+    /**
+     * @brief get per-stream counters, FPS are measured since the previous call
+     */
+    std::vector<StreamStats> GetStats();
+
+private:
+    struct StreamState
+    {
+        std::unique_ptr<StreamSource> source;
+        bool busy = false;
+        uint64_t detected = 0;
+        uint64_t skipped = 0;
+        uint64_t last_captured = 0;
+        uint64_t last_detected = 0;
+    };
+
+    DetectorPool &pool_;
+    StreamScheduler scheduler_;
+    std::vector<StreamState> streams_;
+    std::vector<std::thread> workers_;
+    Callback callback_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point last_stats_;
+
+    void WorkerLoop();
+    bool IsFinishedLocked() const;
+};
+
+}   // namespace Infer
+
+#endif  // STREAM_RUNNER_HPP_
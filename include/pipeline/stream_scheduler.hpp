@@ -0,0 +1,57 @@
+#ifndef STREAM_SCHEDULER_HPP_
+#define STREAM_SCHEDULER_HPP_
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace Infer
+{
+
+enum class SchedulePolicy
+{
+    WeightedRoundRobin,     // share detections in proportion to stream weights
+    Deadline                // detect the frame closest to its deadline first
+};
+
+/**
+ * @brief parse a schedule policy name
+ * @param name      "WeightedRoundRobin" or "Deadline"
+ * @param policy    parsed policy
+ * @return whether the name is known
+ */
+bool ParseSchedulePolicy(const std::string &name, SchedulePolicy &policy);
+
+class StreamScheduler
+{
+public:
+    struct Candidate
+    {
+        size_t stream;
+        int weight;
+        std::chrono::steady_clock::time_point timestamp;
+    };
+
+    /**
+     * @param policy        schedule policy
+     * @param deadline_ms   latency budget of a weight 1 stream, higher weights get proportionally shorter deadlines
+     */
+    StreamScheduler(const SchedulePolicy policy, const int deadline_ms);
+    ~StreamScheduler() = default;
+
+    /**
+     * @brief pick the stream to be detected next, not thread-safe
+     * @param candidates    streams with a pending frame, must not be empty
+     * @return index of the picked stream
+     */
+    size_t Pick(const std::vector<Candidate> &candidates);
+
+private:
+    SchedulePolicy policy_;
+    std::chrono::microseconds deadline_;
+    std::vector<int> current_;      // smooth weighted round robin credit of each stream
+};
+
+}   // namespace Infer
+
+#endif  // STREAM_SCHEDULER_HPP_
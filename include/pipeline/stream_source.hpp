@@ -0,0 +1,115 @@
+#ifndef STREAM_SOURCE_HPP_
+#define STREAM_SOURCE_HPP_
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <opencv2/opencv.hpp>
+#include "camera_handler.hpp"
+#include "pipeline/region_filter.hpp"
+#include "pipeline/motion_gate.hpp"
+
+namespace Infer
+{
+
+struct StreamFrame
+{
+    cv::Mat image;
+    PixelFormat format = PixelFormat::BGR;
+    int scale = 1;      // factor the image is downscaled by from the capture resolution
+    uint64_t id = 0;
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+class StreamSource
+{
+public:
+    /**
+     * @param name      stream name for logs and statistics
+     * @param weight    scheduling weight, streams with higher weights are detected more often
+     */
+    StreamSource(const std::string &name, int weight);
+    ~StreamSource();
+
+    // disable copy and move since the capture thread refers to the stream
+    StreamSource(const StreamSource &) = delete;
+    StreamSource & operator=(const StreamSource &) = delete;
+    StreamSource(StreamSource &&) = delete;
+    StreamSource & operator=(StreamSource &&) = delete;
+
+    /**
+     * @brief open the source
+     * @param source            camera index ("0", "1", ...), video file, stream URL or GStreamer pipeline
+     * @param width, height     requested camera resolution
+     * @param fps               requested camera FPS
+     * @param format            requested camera pixel format
+     * @param mjpeg             whether to capture MJPEG and decode it at reduced size
+     * @param min_size          minimum long side of decoded MJPEG frames
+     * @return whether the source was opened
+     */
+    bool Open(const std::string &source, int width, int height, int fps,
+        PixelFormat format, bool mjpeg, int min_size);
+
+    /**
+     * @brief start the capture thread
+     * @param on_frame  called from the capture thread after a new frame or the end of the stream
+     */
+    void Start(std::function<void()> on_frame);
+    void Stop();
+
+    /**
+     * @brief take the latest captured frame, older frames are dropped
+     * @param frame     latest frame
+     * @return whether a new frame was available
+     */
+    bool TakeFrame(StreamFrame &frame);
+    bool HasFrame() const;
+    /**
+     * @brief get the capture time of the pending frame
+     * @param timestamp     capture time of the pending frame
+     * @return whether a new frame was available
+     */
+    bool PeekTimestamp(std::chrono::steady_clock::time_point &timestamp) const;
+    bool IsFinished() const;
+
+    const std::string & GetName() const;
+    int GetWeight() const;
+    /**
+     * @brief factor frames are downscaled by from the capture resolution, see CameraHandler::GetFrameScale
+     */
+    int GetFrameScale() const;
+    uint64_t GetCapturedCount() const;
+    uint64_t GetDroppedCount() const;
+
+    // per-stream state, only used by the worker currently detecting this stream
+    RegionFilter region_filter;
+    MotionGate motion_gate;
+    std::vector<Object> last_objects;
+
+private:
+    std::string name_;
+    int weight_;
+    CameraHandler camera_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> finished_{false};
+    std::function<void()> on_frame_;
+
+    mutable std::mutex mutex_;
+    StreamFrame frame_;
+    bool has_frame_ = false;
+    uint64_t captured_ = 0;
+    uint64_t dropped_ = 0;
+
+    void CaptureLoop();
+};
+
+}   // namespace Infer
+
+#endif  // STREAM_SOURCE_HPP_
@@ -0,0 +1,38 @@
+#ifndef PIXEL_FORMAT_HPP_
+#define PIXEL_FORMAT_HPP_
+
+#include <string>
+
+namespace Infer
+{
+
+// pixel formats of frames passed from cameras to detectors
+enum class PixelFormat
+{
+    BGR,    // CV_8UC3, interleaved
+    YUYV,   // CV_8UC2, packed YUV 4:2:2
+    NV12    // CV_8UC1 with rows * 3 / 2 rows, Y plane followed by interleaved UV plane
+};
+
+/**
+ * @brief parse pixel format from its name
+ * @param name      format name: BGR, YUYV or NV12
+ * @param format    parsed format
+ * @return whether the name is known
+ */
+inline bool ParsePixelFormat(const std::string &name, PixelFormat &format)
+{
+    if (name == "BGR")
+        format = PixelFormat::BGR;
+    else if (name == "YUYV")
+        format = PixelFormat::YUYV;
+    else if (name == "NV12")
+        format = PixelFormat::NV12;
+    else
+        return false;
+    return true;
+}
+
+}   // namespace Infer
+
+#endif  // PIXEL_FORMAT_HPP_
@@ -1,5 +1,9 @@
 #include "camera_handler.hpp"
 
+#ifdef WITH_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
 CameraHandler::CameraHandler()
 {
 
@@ -16,6 +20,7 @@ bool CameraHandler::Open(int id, int width, int height, int fps)
         return true;
 
     camera_id_ = id;
+    source_.clear();
     frame_width_ = width;
     frame_height_ = height;
     fps_ = fps;
@@ -23,10 +28,29 @@ bool CameraHandler::Open(int id, int width, int height, int fps)
     return InitCamera();
 }
 
+bool CameraHandler::Open(const std::string &source, int width, int height, int fps)
+{
+    if (camera_.isOpened())
+        return true;
+
+    camera_id_ = -1;
+    source_ = source;
+    frame_width_ = width;
+    frame_height_ = height;
+    fps_ = fps;
+
+    return InitCamera();
+}
+
 void CameraHandler::Close()
 {
     if (camera_.isOpened())
         camera_.release();
+#ifdef WITH_TURBOJPEG
+    if (jpeg_decoder_ != nullptr)
+        tjDestroy(static_cast<tjhandle>(jpeg_decoder_));
+#endif
+    jpeg_decoder_ = nullptr;
 }
 
 bool CameraHandler::IsOpened() const
@@ -38,7 +62,33 @@ bool CameraHandler::GetFrame(cv::Mat &frame)
 {
     if (!IsOpened())
         return false;
-    return camera_.read(frame);
+    bool is_valid;
+    if (mjpeg_)
+    {
+        if (!camera_.read(jpeg_))
+            return false;
+        is_valid = DecodeMJPEG(frame);
+    }
+    else
+    {
+        if (!camera_.read(frame))
+            return false;
+        is_valid = format_ == Infer::PixelFormat::BGR || ShapeRawFrame(frame);
+    }
+
+    // corrupt frames are common on USB cameras, they are skipped instead of ending the stream
+    if (!is_valid)
+    {
+        frame.release();
+        if (skipped_++ % 100 == 0)
+            std::cout << "Warning: Skipped a corrupt frame, " << skipped_ << " so far\n";
+    }
+    return true;
+}
+
+uint64_t CameraHandler::GetSkippedCount() const
+{
+    return skipped_;
 }
 
 int CameraHandler::GetActualWidth() const
@@ -51,6 +101,21 @@ int CameraHandler::GetActualHeight() const
     return frame_height_;
 }
 
+int CameraHandler::GetActualFPS() const
+{
+    return fps_;
+}
+
+int CameraHandler::GetFrameScale() const
+{
+    return mjpeg_ ? mjpeg_denom_ : 1;
+}
+
+bool CameraHandler::IsDevice() const
+{
+    return source_.empty();
+}
+
 void CameraHandler::SetResolution(int width, int height)
 {
     frame_width_ = width;
@@ -69,14 +134,117 @@ void CameraHandler::SetFPS(int fps)
         camera_.set(cv::CAP_PROP_FPS, fps_);
 }
 
+void CameraHandler::SetPixelFormat(Infer::PixelFormat format)
+{
+    format_ = format;
+}
+
+Infer::PixelFormat CameraHandler::GetPixelFormat() const
+{
+    return format_;
+}
+
+void CameraHandler::SetMJPEG(bool enable, int min_size)
+{
+    mjpeg_ = enable;
+    mjpeg_min_size_ = min_size;
+}
+
+bool CameraHandler::DecodeMJPEG(cv::Mat &frame)
+{
+#ifdef WITH_TURBOJPEG
+    auto decoder = static_cast<tjhandle>(jpeg_decoder_);
+    int width, height, subsamp, colorspace;
+    if (tjDecompressHeader3(decoder, jpeg_.data, jpeg_.total(), &width, &height, &subsamp, &colorspace) != 0)
+        return false;
+    tjscalingfactor factor = {1, mjpeg_denom_};
+    frame.create(TJSCALED(height, factor), TJSCALED(width, factor), CV_8UC3);
+    return tjDecompress2(decoder, jpeg_.data, jpeg_.total(), frame.data,
+        frame.cols, static_cast<int>(frame.step), frame.rows, TJPF_BGR, TJFLAG_FASTDCT) == 0;
+#else
+    // libjpeg used by OpenCV also decodes with a scaled IDCT for reduced modes
+    int flags = cv::IMREAD_COLOR;
+    if (mjpeg_denom_ == 2)
+        flags = cv::IMREAD_REDUCED_COLOR_2;
+    else if (mjpeg_denom_ == 4)
+        flags = cv::IMREAD_REDUCED_COLOR_4;
+    else if (mjpeg_denom_ == 8)
+        flags = cv::IMREAD_REDUCED_COLOR_8;
+    cv::imdecode(jpeg_, flags, &frame);
+    return !frame.empty();
+#endif
+}
+
+bool CameraHandler::ShapeRawFrame(cv::Mat &frame) const
+{
+    // without RGB conversion V4L2 returns the buffer as a 1 x bytesused row
+    const size_t width = static_cast<size_t>(frame_width_);
+    const size_t height = static_cast<size_t>(frame_height_);
+    const size_t expected = format_ == Infer::PixelFormat::YUYV ? width * height * 2 : width * height * 3 / 2;
+    if (frame.empty() || !frame.isContinuous() || frame.total() * frame.elemSize() != expected)
+        return false;
+
+    if (format_ == Infer::PixelFormat::YUYV)
+        frame = frame.reshape(2, frame_height_);
+    else
+        frame = frame.reshape(1, frame_height_ * 3 / 2);
+    return true;
+}
+
 bool CameraHandler::InitCamera()
 {
-    camera_.open(camera_id_);
+    if (IsDevice())
+        camera_.open(camera_id_);
+    else
+        camera_.open(source_);
     if (!camera_.isOpened())
     {
         return false;
     }
 
+    // files and streams have fixed properties
+    if (!IsDevice())
+    {
+        mjpeg_ = false;
+        frame_width_ = static_cast<int>(camera_.get(cv::CAP_PROP_FRAME_WIDTH));
+        frame_height_ = static_cast<int>(camera_.get(cv::CAP_PROP_FRAME_HEIGHT));
+        fps_ = static_cast<int>(camera_.get(cv::CAP_PROP_FPS));
+        format_ = Infer::PixelFormat::BGR;
+        return true;
+    }
+
+    // request raw YUV buffers to skip the conversion to BGR
+    if (format_ != Infer::PixelFormat::BGR)
+    {
+        int fourcc = format_ == Infer::PixelFormat::YUYV ?
+            cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V') : cv::VideoWriter::fourcc('N', 'V', '1', '2');
+        camera_.set(cv::CAP_PROP_FOURCC, fourcc);
+        bool is_raw = static_cast<int>(camera_.get(cv::CAP_PROP_FOURCC)) == fourcc &&
+            camera_.set(cv::CAP_PROP_CONVERT_RGB, 0);
+        if (!is_raw)
+        {
+            std::cout << "Warning: Camera does not support raw output of the requested format, using BGR\n";
+            camera_.set(cv::CAP_PROP_CONVERT_RGB, 1);
+            format_ = Infer::PixelFormat::BGR;
+        }
+    }
+
+    // request MJPEG and decode it ourselves at reduced size, raw YUV output takes precedence
+    mjpeg_ = mjpeg_ && format_ == Infer::PixelFormat::BGR;
+    if (mjpeg_)
+    {
+        camera_.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+        bool is_raw = static_cast<int>(camera_.get(cv::CAP_PROP_FOURCC)) == cv::VideoWriter::fourcc('M', 'J', 'P', 'G') &&
+            camera_.set(cv::CAP_PROP_CONVERT_RGB, 0);
+        if (!is_raw)
+        {
+            std::cout << "Warning: Camera does not support raw MJPEG output, using full size decoding\n";
+            camera_.set(cv::CAP_PROP_CONVERT_RGB, 1);
+            mjpeg_ = false;
+        }
+    }
+
+    // the resolution is set after the fourcc, changing the fourcc may reset it on V4L2
     camera_.set(cv::CAP_PROP_FRAME_WIDTH, frame_width_);
     camera_.set(cv::CAP_PROP_FRAME_HEIGHT, frame_height_);
     camera_.set(cv::CAP_PROP_FPS, fps_);
@@ -97,6 +265,20 @@ bool CameraHandler::InitCamera()
         std::cout << " - Actual FPS: " << actual_fps << "\n";
     }
 
+    if (mjpeg_)
+    {
+        // largest IDCT scaling that keeps the long side above the minimum size
+        mjpeg_denom_ = 1;
+        while (mjpeg_denom_ < 8 && std::max(frame_width_, frame_height_) / (mjpeg_denom_ * 2) >= mjpeg_min_size_)
+            mjpeg_denom_ *= 2;
+#ifdef WITH_TURBOJPEG
+        if (jpeg_decoder_ == nullptr)
+            jpeg_decoder_ = tjInitDecompress();
+        if (jpeg_decoder_ == nullptr)
+            return false;
+#endif
+    }
+
     return true;
 }
 
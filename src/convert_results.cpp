@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cinttypes>
+
+#include "json.hpp"
+
+#include "pipeline/result_log.hpp"
+
+std::string EscapeJSON(const std::string &text)
+{
+    return nlohmann::json(text).dump();
+}
+
+std::string EscapeCSV(const std::string &text)
+{
+    if (text.find_first_of(",\"\n") == std::string::npos)
+        return text;
+    std::string escaped = "\"";
+    for (char c : text)
+        escaped += c == '"' ? std::string("\"\"") : std::string(1, c);
+    return escaped + "\"";
+}
+
+// one line per frame, rows of a frame are consecutive in the log
+void WriteJSONLines(const Infer::ResultLogReader &reader, const std::vector<std::string> &labels, std::FILE *out)
+{
+    bool open = false;
+    uint64_t frame_id = 0;
+    uint16_t stream = 0;
+    bool first_object = true;
+    for (size_t c = 0; c < reader.GetChunkCount(); ++c)
+    {
+        const Infer::ResultChunk &chunk = reader.GetChunk(c);
+        for (size_t i = 0; i < chunk.rows; ++i)
+        {
+            if (open == false || chunk.frame_id[i] != frame_id || chunk.stream[i] != stream)
+            {
+                if (open)
+                    std::fputs("]}\n", out);
+                frame_id = chunk.frame_id[i];
+                stream = chunk.stream[i];
+                std::fprintf(out, "{\"stream\":%u,\"frame\":%" PRIu64 ",\"timestamp_us\":%" PRId64 ",\"objects\":[",
+                    stream, frame_id, chunk.timestamp_us[i]);
+                open = true;
+                first_object = true;
+            }
+            // label -1 marks a frame without objects
+            if (chunk.label[i] < 0)
+                continue;
+
+            std::fprintf(out, "%s{\"label\":%d,", first_object ? "" : ",", chunk.label[i]);
+            if (chunk.label[i] < static_cast<int>(labels.size()))
+                std::fprintf(out, "\"name\":%s,", EscapeJSON(labels[chunk.label[i]]).c_str());
+            std::fprintf(out, "\"prob\":%.4f,\"box\":[%.1f,%.1f,%.1f,%.1f]}",
+                chunk.prob[i], chunk.x[i], chunk.y[i], chunk.width[i], chunk.height[i]);
+            first_object = false;
+        }
+    }
+    if (open)
+        std::fputs("]}\n", out);
+}
+
+// one line per object, frames without objects are left out
+void WriteCSV(const Infer::ResultLogReader &reader, const std::vector<std::string> &labels, std::FILE *out)
+{
+    std::fputs("stream,frame,timestamp_us,label,name,prob,x,y,width,height\n", out);
+    for (size_t c = 0; c < reader.GetChunkCount(); ++c)
+    {
+        const Infer::ResultChunk &chunk = reader.GetChunk(c);
+        for (size_t i = 0; i < chunk.rows; ++i)
+        {
+            if (chunk.label[i] < 0)
+                continue;
+            std::string name = chunk.label[i] < static_cast<int>(labels.size()) ? EscapeCSV(labels[chunk.label[i]]) : "";
+            std::fprintf(out, "%u,%" PRIu64 ",%" PRId64 ",%d,%s,%.4f,%.1f,%.1f,%.1f,%.1f\n",
+                chunk.stream[i], chunk.frame_id[i], chunk.timestamp_us[i], chunk.label[i], name.c_str(),
+                chunk.prob[i], chunk.x[i], chunk.y[i], chunk.width[i], chunk.height[i]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <results.bin> <output.jsonl|output.csv> [config for label names]\n";
+        return 1;
+    }
+    std::string input_path = argv[1];
+    std::string output_path = argv[2];
+
+    // label names are optional
+    std::vector<std::string> labels;
+    if (argc == 4)
+    {
+        try
+        {
+            std::ifstream config_file(argv[3]);
+            nlohmann::json config = nlohmann::json::parse(config_file, nullptr, true, true);
+            labels = config.at("YOLOv5").at("Labels").get<std::vector<std::string>>();
+        }
+        catch(const nlohmann::json::exception &e)
+        {
+            std::cout << "Failed to read JSON config at " << argv[3] << "\n";
+            return 1;
+        }
+    }
+
+    Infer::ResultLogReader reader;
+    if (reader.Open(input_path) == false)
+    {
+        std::cout << "Failed to open " << input_path << "\n";
+        return 1;
+    }
+
+    bool csv = output_path.size() >= 4 && output_path.compare(output_path.size() - 4, 4, ".csv") == 0;
+    std::FILE *out = std::fopen(output_path.c_str(), "w");
+    if (out == nullptr)
+    {
+        std::cout << "Failed to open " << output_path << "\n";
+        return 1;
+    }
+    std::vector<char> buffer(1 << 20);
+    std::setvbuf(out, buffer.data(), _IOFBF, buffer.size());
+
+    if (csv)
+        WriteCSV(reader, labels, out);
+    else
+        WriteJSONLines(reader, labels, out);
+    std::fclose(out);
+
+    std::cout << "Converted " << reader.GetRowCount() << " rows in " << reader.GetChunkCount() << " chunks\n";
+    return 0;
+}
@@ -3,20 +3,43 @@
 #include <filesystem>
 #include <string>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <csignal>
 
 #include <opencv2/opencv.hpp>
 #include "json.hpp"
 
 #include "camera_handler.hpp"
+#include "pipeline/config_loader.hpp"
+#include "pipeline/region_filter.hpp"
+#include "pipeline/motion_gate.hpp"
+#include "pipeline/deadline_detector.hpp"
+#include "pipeline/resolution_controller.hpp"
+#include "pipeline/detection_publisher.hpp"
+#include "pipeline/detection_sink.hpp"
+#include "pipeline/object_renderer.hpp"
+#include "pipeline/model_reloader.hpp"
+#include "pipeline/config_watcher.hpp"
 
 #include "detectors/base_detector.hpp"
-#include "detectors/ncnn_detector.hpp"
-#include "detectors/ov_detector.hpp"
-#include "detectors/mnn_detector.hpp"
-#include "detectors/ort_detector.hpp"
-#include "detectors/cv_detector.hpp"
 
-void ShowFPS(cv::Mat &frame, int &frame_count, int &fps, std::chrono::steady_clock::time_point &start)
+static std::atomic<bool> g_stop{false};
+static Infer::ModelReloader *g_reloader = nullptr;
+
+void OnSignal(int)
+{
+    g_stop = true;
+}
+
+void OnReload(int)
+{
+    if (g_reloader != nullptr)
+        g_reloader->RequestReload();
+}
+
+void UpdateFPS(int &frame_count, std::atomic<int> &fps, std::chrono::steady_clock::time_point &start)
 {
     ++frame_count;
     auto end = std::chrono::steady_clock::now();
@@ -28,9 +51,11 @@ void ShowFPS(cv::Mat &frame, int &frame_count, int &fps, std::chrono::steady_clo
         frame_count = 0;
         start = end;
     }
+}
 
-    std::string fps_text = "FPS: " + std::to_string(fps);
-    cv::putText(frame, fps_text, cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0), 2);
+void ShowText(cv::Mat &frame, const std::string &text, const int line)
+{
+    cv::putText(frame, text, cv::Point(10, 30 + 25 * line), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0), 2);
 }
 
 int main(int argc, char *argv[])
@@ -55,12 +80,18 @@ int main(int argc, char *argv[])
     // get model path
     std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
     int framework = config.at("Inference").at("Framework").get<int>();
-    std::filesystem::path path(config_path);
-    std::string model_path = path.parent_path().string() + "/models/" +
-        support_frameworks[framework] + "/" +
-        config.at("YOLOv5").at("ModelName").get<std::string>();
+    std::string model_path = Infer::GetModelPath(config, config_path);
     // get labels
     auto labels = config.at("YOLOv5").at("Labels").get<std::vector<std::string>>();
+    // created first, a stdout sink moves all the messages below to standard error
+    std::unique_ptr<Infer::DetectionSink> sink;
+    if (Infer::CreateDetectionSink(
+        config.at("Camera").at("Sink").at("Type").get<std::string>(),
+        config.at("Camera").at("Sink").at("Path").get<std::string>(),
+        labels,
+        sink
+    ) == false)
+        return 1;
 
     // show configs
     std::cout << "Camera ID: " << config.at("Camera").at("CameraID").get<int>() << "\n";
@@ -70,44 +101,119 @@ int main(int argc, char *argv[])
     std::cout << "Model name: " << model_path << "\n";
 
     // load framework
-    std::unique_ptr<Infer::BaseDetector> detector = nullptr;
-    switch (framework)
-    {
-        case 0:
-            detector = std::make_unique<Infer::NCNNDetector>();
-            break;
-        case 1:
-            detector = std::make_unique<Infer::OVDetector>();
-            break;
-        case 2:
-            detector = std::make_unique<Infer::MNNDetector>();
-            break;
-        case 3:
-            detector = std::make_unique<Infer::ORTDetector>();
-            break;
-        case 4:
-            detector = std::make_unique<Infer::CVDetector>();
-            break;
-        default:
-            std::cout << "Unknown model: " << framework << "\n";
-            return 0;
-    }
-    if (detector->Initialize(
-        config.at("Inference").at("Threads").get<int>(),
-        model_path,
-        config.at("YOLOv5").at("ConfThreshold").get<float>(),
-        config.at("YOLOv5").at("NMSThreshold").get<float>(),
-        config.at("YOLOv5").at("TargetSize").get<int>(),
-        config.at("YOLOv5").at("MaxStride").get<int>(),
-        static_cast<int>(labels.size())
-    ) == false)
+    std::unique_ptr<Infer::BaseDetector> detector = Infer::CreateDetector(config, model_path);
+    if (detector == nullptr)
     {
         std::cout << "Failed to initialize framework\n";
         return 1;
     }
 
+    // regions of interest, set once the camera is open
+    Infer::RegionFilter region_filter;
+
+    // motion gate
+    Infer::MotionGate motion_gate;
+    const auto &gate_config = config.at("Camera").at("MotionGate");
+    motion_gate.Configure(
+        gate_config.at("Enable").get<bool>(),
+        gate_config.at("Width").get<int>(),
+        gate_config.at("PixelThreshold").get<int>(),
+        gate_config.at("MinChangedRatio").get<float>(),
+        gate_config.at("MaxSkipFrames").get<int>()
+    );
+
+    // adaptive resolution
+    Infer::ResolutionController resolution_controller;
+    const auto &resolution_config = config.at("AdaptiveResolution");
+    bool adaptive_resolution = resolution_config.at("Enable").get<bool>();
+    resolution_controller.Configure(
+        resolution_config.at("Sizes").get<std::vector<int>>(),
+        resolution_config.at("TargetFPS").get<double>(),
+        resolution_config.at("MinObjectPixels").get<int>(),
+        resolution_config.at("HoldFrames").get<int>(),
+        resolution_config.at("Window").get<int>()
+    );
+
+    // detection stream for subscribers on a Unix domain socket
+    Infer::DetectionPublisher publisher;
+    const auto &publish_config = config.at("Publish");
+    if (publish_config.at("Enable").get<bool>())
+    {
+        std::string socket_path = publish_config.at("SocketPath").get<std::string>();
+        if (publisher.Open(socket_path, publish_config.at("MaxPendingKB").get<size_t>() * 1024))
+            std::cout << "Publishing detections on " << socket_path << "\n";
+    }
+
+    // the reloaded detector is handed to the detection loop and swapped in before the next frame
+    Infer::ModelReloader reloader;
+    std::mutex reload_mutex;
+    std::unique_ptr<Infer::BaseDetector> reloaded_detector;
+    std::atomic<bool> reload_pending{false};
+    // the first camera frame and the adaptive sizes, the new detector is warmed up on them through the region filter
+    std::mutex warmup_mutex;
+    cv::Mat warmup_frame;
+    Infer::PixelFormat warmup_format = Infer::PixelFormat::BGR;
+    std::vector<int> warmup_sizes;
+    std::atomic<bool> warmup_sampled{false};
+    std::atomic<bool> reloaded_prewarmed{false};
+    const auto &reload_config = config.at("HotReload");
+    const bool hot_reload = reload_config.at("Enable").get<bool>();
+    if (hot_reload)
+    {
+        reloader.Start(
+            model_path,
+            reload_config.at("WatchFiles").get<bool>(),
+            reload_config.at("PollMs").get<int>(),
+            [&config, &model_path]() { return Infer::CreateDetectors(config, model_path, 1); },
+            [&](Infer::BaseDetector &target) {
+                // without a frame yet, the first frame warms it up like the initial detector
+                std::lock_guard<std::mutex> lock(warmup_mutex);
+                reloaded_prewarmed = warmup_frame.empty() == false;
+                if (warmup_frame.empty())
+                    return;
+                // every adaptive size runs here in the background, so that the swap does not stall the stream
+                for (const int size : warmup_sizes)
+                {
+                    target.SetTargetSize(size);
+                    region_filter.Detect(target, warmup_frame, warmup_format);
+                }
+                if (warmup_sizes.empty())
+                    region_filter.Detect(target, warmup_frame, warmup_format);
+            },
+            [&](std::vector<std::unique_ptr<Infer::BaseDetector>> detectors) {
+                std::lock_guard<std::mutex> lock(reload_mutex);
+                reloaded_detector = std::move(detectors.front());
+                reload_pending = true;
+            }
+        );
+        g_reloader = &reloader;
+    }
+
+    // thresholds, detection limits, class filter and labels follow the config file
+    Infer::ConfigWatcher config_watcher;
+    const auto &live_config = config.at("LiveConfig");
+    if (config_watcher.Start(
+        config_path,
+        config,
+        live_config.at("Enable").get<bool>(),
+        live_config.at("PollMs").get<int>(),
+        nullptr
+    ) == false)
+        return 1;
+
     // --- Open camera
+    Infer::PixelFormat format;
+    if (Infer::ParsePixelFormat(config.at("Camera").at("PixelFormat").get<std::string>(), format) == false)
+    {
+        std::cout << "Unknown pixel format: " << config.at("Camera").at("PixelFormat").get<std::string>() << "\n";
+        return 1;
+    }
     CameraHandler ch;
+    ch.SetPixelFormat(format);
+    ch.SetMJPEG(
+        config.at("Camera").at("MJPEG").get<bool>(),
+        config.at("YOLOv5").at("TargetSize").get<int>()
+    );
     if (ch.Open(
         config.at("Camera").at("CameraID").get<int>(),
         config.at("Camera").at("FrameWidth").get<int>(),
@@ -119,38 +225,267 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    cv::Mat frame;
-    cv::namedWindow("Camera", cv::WINDOW_AUTOSIZE);
+    // the camera falls back to BGR if the raw format is not supported
+    format = ch.GetPixelFormat();
 
-    std::cout << "* Press [esc] to quit *\n";
+    // regions and results are in capture coordinates, MJPEG frames may be decoded at reduced size
+    const int frame_scale = ch.GetFrameScale();
+    std::vector<std::vector<cv::Point>> exclusions;
+    for (const auto &polygon : config.at("Camera").at("ExcludeRegions"))
+        exclusions.emplace_back(Infer::ToPolygon(polygon));
+    region_filter.SetRegions(Infer::ToPolygon(config.at("Camera").at("ROI")), exclusions, frame_scale);
 
-    auto start = std::chrono::steady_clock::now();
-    int fps = 0, frame_count = 0;
+    // --- Output
+    // headless runs skip all drawing and the GUI loop, an optional preview is drawn at a lower rate
+    bool headless = config.at("Camera").at("Headless").get<bool>();
+    double preview_fps = config.at("Camera").at("PreviewFPS").get<double>();
+    bool preview = headless == false || preview_fps > 0.0;
+    Infer::ObjectRenderer renderer(labels, config.at("Camera").at("PreviewDecimation").get<int>());
 
-    while (true)
-    {
-        if (!ch.GetFrame(frame))
+    std::atomic<int> fps{0};
+    // status lines, read on the detection thread
+    auto get_status = [&]() {
+        std::vector<std::string> status = {"FPS: " + std::to_string(fps)};
+        // show the degradation level when a latency budget is set
+        if (auto *deadline_detector = dynamic_cast<Infer::DeadlineDetector *>(detector.get()))
+            status.push_back(std::string("Level: ") + Infer::GetDegradeLevelName(deadline_detector->GetLastLevel()));
+        if (adaptive_resolution)
+            status.push_back("Size: " + std::to_string(resolution_controller.GetTargetSize()));
+        return status;
+    };
+    // convert and downscale a frame for display, then draw results and status,
+    // only the display is mirrored so that detection and results stay in camera coordinates
+    std::shared_ptr<const Infer::LiveSettings> drawn_settings = config_watcher.Get();
+    auto draw = [&](const cv::Mat &frame, cv::Mat &display, const std::vector<Infer::Object> &objects,
+        const std::vector<std::string> &status) {
+        std::shared_ptr<const Infer::LiveSettings> settings = config_watcher.Get();
+        if (settings != drawn_settings)
         {
-            std::cout << "Failed to get frame\n";
-            break;
+            renderer.SetLabels(settings->labels);
+            drawn_settings = settings;
         }
+        if (format == Infer::PixelFormat::BGR)
+            renderer.Prepare(frame, display);
+        else
+        {
+            cv::Mat bgr;
+            cv::cvtColor(frame, bgr,
+                format == Infer::PixelFormat::YUYV ? cv::COLOR_YUV2BGR_YUYV : cv::COLOR_YUV2BGR_NV12);
+            renderer.Prepare(bgr, display);
+        }
+        // the regions are plain lines and flipped with the image, the boxes are mirrored to keep labels readable
+        region_filter.DrawRegions(display, renderer.GetDecimation());
+        cv::flip(display, display, 1);
+        std::vector<Infer::Object> mirrored(objects);
+        for (auto &obj : mirrored)
+            obj.rect.x = frame.cols - obj.rect.x - obj.rect.width;
+        renderer.Draw(display, mirrored);
+        for (size_t i = 0; i < status.size(); ++i)
+            ShowText(display, status[i], static_cast<int>(i));
+    };
+
+    // latest frame handed from the headless loop to the preview
+    std::mutex preview_mutex;
+    cv::Mat preview_frame;
+    std::vector<Infer::Object> preview_objects;
+    std::vector<std::string> preview_status;
+    bool preview_pending = false;
+    const auto preview_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(preview_fps > 0.0 ? 1.0 / preview_fps : 0.0));
+
+    auto run = [&]() {
+        cv::Mat frame, display;
+        std::vector<Infer::Object> objects;
+        auto start = std::chrono::steady_clock::now();
+        auto last_preview = start - preview_interval;
+        int frame_count = 0;
+        bool prewarmed = false;
+        uint64_t frame_id = 0;
+        std::shared_ptr<const Infer::LiveSettings> applied_settings = config_watcher.Get();
+
+        while (!g_stop)
+        {
+            if (!ch.GetFrame(frame))
+            {
+                std::cout << "Failed to get frame\n";
+                g_stop = true;
+                break;
+            }
+            // corrupt frames are skipped by the camera
+            if (frame.empty())
+                continue;
+            ++frame_id;
+            auto capture_time = std::chrono::system_clock::now();
 
-        // detect
-        cv::flip(frame, frame, 1);
-        auto objects = detector->Detect(frame);
-        detector->DrawObjects(frame, objects, labels);
+            // the old detector has no frame in flight here
+            if (reload_pending)
+            {
+                std::lock_guard<std::mutex> lock(reload_mutex);
+                detector = std::move(reloaded_detector);
+                reload_pending = false;
+                // warmed up at every adaptive size by the reloader, only the current size is selected
+                if (reloaded_prewarmed && adaptive_resolution)
+                    detector->SetTargetSize(resolution_controller.GetTargetSize());
+                else if (reloaded_prewarmed == false)
+                    prewarmed = false;
+                // the new detector starts with the settings of the original config
+                applied_settings = nullptr;
+            }
+            std::shared_ptr<const Infer::LiveSettings> settings = config_watcher.Get();
+            if (settings != applied_settings)
+            {
+                detector->SetPostprocessSettings(settings->postprocess);
+                if (sink != nullptr)
+                    sink->SetLabels(settings->labels);
+                applied_settings = settings;
+            }
 
-        ShowFPS(frame, frame_count, fps, start);
+            // run every size once on the first frame so that switching does not stall
+            if (adaptive_resolution && prewarmed == false)
+            {
+                prewarmed = true;
+                // through the region filter, so that the crop size is warmed up
+                if (resolution_controller.Prewarm(*detector, [&](Infer::BaseDetector &target) {
+                    region_filter.Detect(target, frame, format);
+                }) == 0)
+                {
+                    std::cout << "No adaptive target size is supported, adaptive resolution disabled\n";
+                    adaptive_resolution = false;
+                    detector->SetTargetSize(config.at("YOLOv5").at("TargetSize").get<int>());
+                }
+            }
+            if (hot_reload && warmup_sampled == false)
+            {
+                std::lock_guard<std::mutex> lock(warmup_mutex);
+                frame.copyTo(warmup_frame);
+                warmup_format = format;
+                if (adaptive_resolution)
+                    warmup_sizes = resolution_controller.GetSizes();
+                warmup_sampled = true;
+            }
 
-        cv::imshow("Camera", frame);
+            // detect, unchanged frames keep the last results
+            auto detect_start = std::chrono::steady_clock::now();
+            bool detected = false;
+            if (format == Infer::PixelFormat::BGR)
+            {
+                if ((detected = motion_gate.Update(frame)))
+                    objects = region_filter.Detect(*detector, frame);
+            }
+            else
+            {
+                // raw frames are detected without conversion and converted only for display
+                if ((detected = motion_gate.Update(frame, format)))
+                    objects = region_filter.Detect(*detector, frame, format);
+            }
+            // subscribers and sinks get every detected frame, skipped frames would repeat the last results
+            if (detected)
+            {
+                int64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    capture_time.time_since_epoch()).count();
+                std::vector<Infer::Object> scaled(objects);
+                Infer::ScaleObjects(scaled, static_cast<float>(frame_scale));
+                publisher.Publish(frame_id, timestamp_us, scaled);
+                if (sink != nullptr)
+                    sink->Write(frame_id, timestamp_us, scaled);
+            }
+            if (adaptive_resolution && detected)
+            {
+                int img_rows = format == Infer::PixelFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
+                std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - detect_start;
+                const int target_size = resolution_controller.Update(latency.count(), objects, img_rows, frame.cols);
+                if (target_size != detector->GetTargetSize())
+                    detector->SetTargetSize(target_size);
+            }
+            UpdateFPS(frame_count, fps, start);
 
-        // press esc to quit
-        if (cv::waitKey(1) == 27)
-            break;
+            if (headless)
+            {
+                // hand a copy to the preview at its own rate, the raw frame is converted there
+                auto now = std::chrono::steady_clock::now();
+                if (preview && now - last_preview >= preview_interval)
+                {
+                    std::lock_guard<std::mutex> lock(preview_mutex);
+                    frame.copyTo(preview_frame);
+                    preview_objects = objects;
+                    preview_status = get_status();
+                    preview_pending = true;
+                    last_preview = now;
+                }
+                continue;
+            }
+
+            draw(frame, display, objects, get_status());
+            cv::imshow("Camera", display);
+
+            // press esc to quit
+            if (cv::waitKey(1) == 27)
+                g_stop = true;
+        }
+    };
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+#ifdef SIGHUP
+    if (g_reloader != nullptr)
+        std::signal(SIGHUP, OnReload);
+#endif
+    if (preview)
+    {
+        cv::namedWindow("Camera", cv::WINDOW_AUTOSIZE);
+        std::cout << "* Press [esc] to quit *\n";
+    }
+    else
+        std::cout << "* Press [ctrl+c] to quit *\n";
+
+    if (headless == false)
+        run();
+    else
+    {
+        // detection runs on a worker thread, HighGUI stays on the main thread
+        std::thread worker(run);
+        const int wait_ms = preview ? std::max(1, static_cast<int>(1000.0 / preview_fps)) : 100;
+        cv::Mat frame, display;
+        std::vector<Infer::Object> objects;
+        std::vector<std::string> status;
+        while (!g_stop)
+        {
+            if (preview == false)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+                continue;
+            }
+
+            bool pending = false;
+            {
+                std::lock_guard<std::mutex> lock(preview_mutex);
+                if (preview_pending)
+                {
+                    cv::swap(frame, preview_frame);
+                    objects.swap(preview_objects);
+                    status.swap(preview_status);
+                    preview_pending = false;
+                    pending = true;
+                }
+            }
+            if (pending)
+            {
+                draw(frame, display, objects, status);
+                cv::imshow("Camera", display);
+            }
+            if (cv::waitKey(wait_ms) == 27)
+                g_stop = true;
+        }
+        worker.join();
     }
 
+    g_reloader = nullptr;
+    reloader.Stop();
+    config_watcher.Stop();
+
     // releasse
-    cv::destroyAllWindows();
+    if (preview)
+        cv::destroyAllWindows();
 
     std::cout << "FPS: " << fps << "\n";
 
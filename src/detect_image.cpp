@@ -8,11 +8,7 @@
 #include "json.hpp"
 
 #include "detectors/base_detector.hpp"
-#include "detectors/ncnn_detector.hpp"
-#include "detectors/ov_detector.hpp"
-#include "detectors/mnn_detector.hpp"
-#include "detectors/ort_detector.hpp"
-#include "detectors/cv_detector.hpp"
+#include "pipeline/config_loader.hpp"
 
 int main (int argc, char *argv[])
 {
@@ -37,9 +33,7 @@ int main (int argc, char *argv[])
     std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
     int framework = config.at("Inference").at("Framework").get<int>();
     std::filesystem::path path(config_path);
-    std::string model_path = path.parent_path().string() + "/models/" +
-        support_frameworks[framework] + "/" +
-        config.at("YOLOv5").at("ModelName").get<std::string>();
+    std::string model_path = Infer::GetModelPath(config, config_path);
     // get labels
     auto labels = config.at("YOLOv5").at("Labels").get<std::vector<std::string>>();
     
@@ -60,37 +54,8 @@ int main (int argc, char *argv[])
 
     // --- Detect
     // load framework
-    std::unique_ptr<Infer::BaseDetector> detector = nullptr;
-    switch (framework)
-    {
-        case 0:
-            detector = std::make_unique<Infer::NCNNDetector>();
-            break;
-        case 1:
-            detector = std::make_unique<Infer::OVDetector>();
-            break;
-        case 2:
-            detector = std::make_unique<Infer::MNNDetector>();
-            break;
-        case 3:
-            detector = std::make_unique<Infer::ORTDetector>();
-            break;
-        case 4:
-            detector = std::make_unique<Infer::CVDetector>();
-            break;
-        default:
-            std::cout << "Unknown model: " << framework << "\n";
-            return 0;
-    }
-    if (detector->Initialize(
-        config.at("Inference").at("Threads").get<int>(),
-        model_path,
-        config.at("YOLOv5").at("ConfThreshold").get<float>(),
-        config.at("YOLOv5").at("NMSThreshold").get<float>(),
-        config.at("YOLOv5").at("TargetSize").get<int>(),
-        config.at("YOLOv5").at("MaxStride").get<int>(),
-        static_cast<int>(labels.size())
-    ) == false)
+    std::unique_ptr<Infer::BaseDetector> detector = Infer::CreateDetector(config, model_path);
+    if (detector == nullptr)
     {
         std::cout << "Failed to initialize framework\n";
         return 1;
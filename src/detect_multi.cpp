@@ -0,0 +1,260 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <csignal>
+
+#include <opencv2/opencv.hpp>
+#include "json.hpp"
+
+#include "pipeline/config_loader.hpp"
+#include "pipeline/detector_pool.hpp"
+#include "pipeline/stream_source.hpp"
+#include "pipeline/stream_runner.hpp"
+#include "pipeline/result_log.hpp"
+#include "pipeline/model_reloader.hpp"
+#include "pipeline/config_watcher.hpp"
+
+#include "detectors/base_detector.hpp"
+
+static std::atomic<bool> g_stop{false};
+static Infer::ModelReloader *g_reloader = nullptr;
+
+void OnSignal(int)
+{
+    g_stop = true;
+}
+
+void OnReload(int)
+{
+    if (g_reloader != nullptr)
+        g_reloader->RequestReload();
+}
+
+int main(int argc, char *argv[])
+{
+    // --- Load configs
+    std::string config_path = "../Config.json";
+    nlohmann::json config;
+    if (argc == 2)
+        config_path = std::string(argv[1]);
+    try
+    {
+        std::ifstream config_file(config_path);
+        config = nlohmann::json::parse(config_file, nullptr, true, true);
+    }
+    catch(const nlohmann::json::exception &e)
+    {
+        // std::cout << e.what() << '\n';
+        std::cout << "Failed to read JSON config at " << config_path << "\n";
+        std::cout << "Use `" << argv[0] << " [path_to_config]` to specify a config file.\n";
+        return 1;
+    }
+    // get model path
+    std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
+    int framework = config.at("Inference").at("Framework").get<int>();
+    std::string model_path = Infer::GetModelPath(config, config_path);
+    const auto &multi_config = config.at("MultiStream");
+    int pool_size = multi_config.at("PoolSize").get<int>();
+
+    // show configs
+    std::cout << "Using " << support_frameworks[framework] << "\n";
+    std::cout << "Threads: " << config.at("Inference").at("Threads").get<int>() << "\n";
+    std::cout << "Detectors: " << pool_size << "\n";
+    std::cout << "Streams: " << multi_config.at("Streams").size() << "\n";
+    std::cout << "Model name: " << model_path << "\n";
+
+    // --- Load detectors
+    // the model is loaded once and shared by the pool if the framework supports it
+    std::vector<std::unique_ptr<Infer::BaseDetector>> detectors = Infer::CreateDetectors(config, model_path, pool_size);
+    if (detectors.empty())
+    {
+        std::cout << "Failed to initialize framework\n";
+        return 1;
+    }
+    Infer::DetectorPool pool;
+    for (auto &detector : detectors)
+        pool.Add(std::move(detector));
+
+    // the reloaded model replaces the pool once warmed up, leased detectors finish their jobs first
+    Infer::ModelReloader reloader;
+    // the first frame of each stream with its region filter, new detectors are warmed up on all of them
+    std::mutex warmup_mutex;
+    std::vector<Infer::StreamFrame> warmup_frames(multi_config.at("Streams").size());
+    std::vector<Infer::RegionFilter> warmup_filters;
+    const auto &reload_config = config.at("HotReload");
+    const bool hot_reload = reload_config.at("Enable").get<bool>();
+    if (hot_reload)
+    {
+        reloader.Start(
+            model_path,
+            reload_config.at("WatchFiles").get<bool>(),
+            reload_config.at("PollMs").get<int>(),
+            [&config, &model_path, pool_size]() { return Infer::CreateDetectors(config, model_path, pool_size); },
+            [&](Infer::BaseDetector &detector) {
+                std::lock_guard<std::mutex> lock(warmup_mutex);
+                for (size_t i = 0; i < warmup_filters.size(); ++i)
+                {
+                    if (warmup_frames[i].image.empty() == false)
+                        warmup_filters[i].Detect(detector, warmup_frames[i].image, warmup_frames[i].format);
+                }
+            },
+            [&pool](std::vector<std::unique_ptr<Infer::BaseDetector>> detectors) { pool.Replace(std::move(detectors)); }
+        );
+        g_reloader = &reloader;
+    }
+
+    // thresholds, detection limits, class filter and labels follow the config file,
+    // leased detectors get them when they are returned
+    Infer::ConfigWatcher config_watcher;
+    const auto &live_config = config.at("LiveConfig");
+    if (config_watcher.Start(
+        config_path,
+        config,
+        live_config.at("Enable").get<bool>(),
+        live_config.at("PollMs").get<int>(),
+        [&pool](std::shared_ptr<const Infer::LiveSettings> settings) {
+            pool.Update([settings](Infer::BaseDetector &detector) {
+                detector.SetPostprocessSettings(settings->postprocess);
+            });
+        }
+    ) == false)
+        return 1;
+
+    Infer::SchedulePolicy policy;
+    if (Infer::ParseSchedulePolicy(multi_config.at("Scheduler").get<std::string>(), policy) == false)
+    {
+        std::cout << "Unknown scheduler: " << multi_config.at("Scheduler").get<std::string>() << "\n";
+        return 1;
+    }
+    Infer::MultiStreamRunner runner(pool, policy, multi_config.at("DeadlineMs").get<int>());
+
+    // --- Open streams, unset camera options fall back to the Camera section
+    const auto &camera_config = config.at("Camera");
+    const auto &gate_config = camera_config.at("MotionGate");
+    for (const auto &stream_config : multi_config.at("Streams"))
+    {
+        std::string source = stream_config.at("Source").is_number() ?
+            std::to_string(stream_config.at("Source").get<int>()) :
+            stream_config.at("Source").get<std::string>();
+        auto stream = std::make_unique<Infer::StreamSource>(
+            stream_config.value("Name", source),
+            stream_config.value("Weight", 1)
+        );
+
+        Infer::PixelFormat format;
+        std::string format_name = stream_config.value("PixelFormat", camera_config.at("PixelFormat").get<std::string>());
+        if (Infer::ParsePixelFormat(format_name, format) == false)
+        {
+            std::cout << "Unknown pixel format: " << format_name << "\n";
+            return 1;
+        }
+        if (stream->Open(
+            source,
+            stream_config.value("FrameWidth", camera_config.at("FrameWidth").get<int>()),
+            stream_config.value("FrameHeight", camera_config.at("FrameHeight").get<int>()),
+            stream_config.value("FPS", camera_config.at("FPS").get<int>()),
+            format,
+            stream_config.value("MJPEG", camera_config.at("MJPEG").get<bool>()),
+            config.at("YOLOv5").at("TargetSize").get<int>()
+        ) == false)
+        {
+            std::cout << "Failed to open stream " << source << "\n";
+            return 1;
+        }
+
+        std::vector<std::vector<cv::Point>> exclusions;
+        for (const auto &polygon : stream_config.value("ExcludeRegions", nlohmann::json::array()))
+            exclusions.emplace_back(Infer::ToPolygon(polygon));
+        // in capture coordinates, MJPEG frames may be decoded at reduced size
+        stream->region_filter.SetRegions(
+            Infer::ToPolygon(stream_config.value("ROI", nlohmann::json::array())), exclusions,
+            stream->GetFrameScale());
+
+        stream->motion_gate.Configure(
+            gate_config.at("Enable").get<bool>(),
+            gate_config.at("Width").get<int>(),
+            gate_config.at("PixelThreshold").get<int>(),
+            gate_config.at("MinChangedRatio").get<float>(),
+            gate_config.at("MaxSkipFrames").get<int>()
+        );
+
+        {
+            std::lock_guard<std::mutex> lock(warmup_mutex);
+            warmup_filters.push_back(stream->region_filter);
+        }
+        runner.AddStream(std::move(stream));
+    }
+
+    std::signal(SIGINT, OnSignal);
+#ifdef SIGHUP
+    if (g_reloader != nullptr)
+        std::signal(SIGHUP, OnReload);
+#endif
+    std::cout << "* Press [ctrl+c] to quit *\n";
+
+    // results of all streams go to one log, converted to JSON Lines or CSV with convert_results
+    Infer::ResultLogWriter result_log;
+    std::string result_log_path = multi_config.at("ResultLog").get<std::string>();
+    if (result_log_path.empty() == false && result_log.Open(result_log_path) == false)
+        return 1;
+    // frame timestamps are steady clock, the log stores wall clock time
+    const auto clock_offset = std::chrono::system_clock::now().time_since_epoch() -
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::steady_clock::now().time_since_epoch());
+
+    // --- Run
+    std::vector<std::atomic<size_t>> object_counts(runner.GetStreamCount());
+    std::vector<std::atomic<bool>> warmup_sampled(runner.GetStreamCount());
+    runner.Start([&](size_t stream, const Infer::StreamFrame &frame, const std::vector<Infer::Object> &objects) {
+        object_counts[stream] = objects.size();
+        if (hot_reload && warmup_sampled[stream] == false)
+        {
+            std::lock_guard<std::mutex> lock(warmup_mutex);
+            frame.image.copyTo(warmup_frames[stream].image);
+            warmup_frames[stream].format = frame.format;
+            warmup_sampled[stream] = true;
+        }
+        int64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(frame.timestamp.time_since_epoch()) +
+            clock_offset).count();
+        // back to capture coordinates
+        if (frame.scale > 1)
+        {
+            std::vector<Infer::Object> scaled(objects);
+            Infer::ScaleObjects(scaled, static_cast<float>(frame.scale));
+            result_log.Append(frame.id, timestamp_us, scaled, static_cast<uint16_t>(stream));
+        }
+        else
+            result_log.Append(frame.id, timestamp_us, objects, static_cast<uint16_t>(stream));
+    });
+
+    while (!g_stop && !runner.IsFinished())
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        auto stats = runner.GetStats();
+        std::cout << std::fixed << std::setprecision(1);
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            std::cout << stats[i].name
+                << "  capture: " << stats[i].capture_fps << " FPS"
+                << "  detect: " << stats[i].detect_fps << " FPS"
+                << "  dropped: " << stats[i].dropped
+                << "  skipped: " << stats[i].skipped
+                << "  objects: " << object_counts[i] << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    g_reloader = nullptr;
+    reloader.Stop();
+    config_watcher.Stop();
+    runner.Stop();
+    result_log.Close();
+
+    return 0;
+}
@@ -0,0 +1,319 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <csignal>
+
+#include <opencv2/opencv.hpp>
+#include "json.hpp"
+
+#include "pipeline/config_loader.hpp"
+#include "pipeline/detector_pool.hpp"
+#include "pipeline/detect_service.hpp"
+#include "pipeline/http_server.hpp"
+#include "pipeline/model_reloader.hpp"
+#include "pipeline/config_watcher.hpp"
+
+#include "detectors/base_detector.hpp"
+
+static std::atomic<bool> g_stop{false};
+static Infer::ModelReloader *g_reloader = nullptr;
+
+void OnSignal(int)
+{
+    g_stop = true;
+}
+
+void OnReload(int)
+{
+    if (g_reloader != nullptr)
+        g_reloader->RequestReload();
+}
+
+void SetError(Infer::HttpResponse &response, const int status, const std::string &message)
+{
+    response.status = status;
+    response.body = nlohmann::json{{"error", message}}.dump();
+}
+
+/**
+ * @brief build a raw frame from the request body
+ * @param request   request with format, width and height query parameters
+ * @param job       job to fill
+ * @return error message, empty on success
+ */
+std::string ParseRawFrame(const Infer::HttpRequest &request, Infer::DetectJob &job)
+{
+    auto format_it = request.query.find("format");
+    if (Infer::ParsePixelFormat(format_it == request.query.end() ? "BGR" : format_it->second, job.format) == false)
+        return "unknown format";
+
+    int width = 0, height = 0;
+    try
+    {
+        width = std::stoi(request.query.at("width"));
+        height = std::stoi(request.query.at("height"));
+    }
+    catch (const std::exception &e)
+    {
+        return "width and height are required";
+    }
+    if (width <= 0 || height <= 0)
+        return "invalid size";
+
+    int rows = height, type = CV_8UC3;
+    size_t expected = static_cast<size_t>(width) * height * 3;
+    if (job.format == Infer::PixelFormat::YUYV)
+    {
+        type = CV_8UC2;
+        expected = static_cast<size_t>(width) * height * 2;
+    }
+    else if (job.format == Infer::PixelFormat::NV12)
+    {
+        if (width % 2 != 0 || height % 2 != 0)
+            return "NV12 frames need an even size";
+        rows = height / 2 * 3;
+        type = CV_8UC1;
+        expected = static_cast<size_t>(width) * height / 2 * 3;
+    }
+    // checked before allocating, the body is already bounded by MaxBodyMB, so the size is too
+    if (request.body.size() != expected)
+        return "body size does not match the frame size";
+    job.frame.create(rows, width, type);
+    std::memcpy(job.frame.data, request.body.data(), request.body.size());
+    return "";
+}
+
+/**
+ * @brief build a gray frame for warming up a detector
+ * @param img_rows, img_cols    image size
+ * @param format                pixel format
+ * @return frame in the layout Detect expects for the format
+ */
+cv::Mat CreateWarmupFrame(const int img_rows, const int img_cols, const Infer::PixelFormat format)
+{
+    if (format == Infer::PixelFormat::YUYV)
+        return cv::Mat(img_rows, img_cols, CV_8UC2, cv::Scalar(114, 128));
+    if (format == Infer::PixelFormat::NV12)
+        return cv::Mat(img_rows / 2 * 3, img_cols, CV_8UC1, cv::Scalar(114));
+    return cv::Mat(img_rows, img_cols, CV_8UC3, cv::Scalar(114, 114, 114));
+}
+
+int main(int argc, char *argv[])
+{
+    // --- Load configs
+    std::string config_path = "../Config.json";
+    nlohmann::json config;
+    if (argc == 2)
+        config_path = std::string(argv[1]);
+    try
+    {
+        std::ifstream config_file(config_path);
+        config = nlohmann::json::parse(config_file, nullptr, true, true);
+    }
+    catch(const nlohmann::json::exception &e)
+    {
+        // std::cout << e.what() << '\n';
+        std::cout << "Failed to read JSON config at " << config_path << "\n";
+        std::cout << "Use `" << argv[0] << " [path_to_config]` to specify a config file.\n";
+        return 1;
+    }
+    // get model path
+    std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
+    int framework = config.at("Inference").at("Framework").get<int>();
+    std::string model_path = Infer::GetModelPath(config, config_path);
+    const auto &server_config = config.at("Server");
+    int pool_size = server_config.at("PoolSize").get<int>();
+
+    // show configs
+    std::cout << "Using " << support_frameworks[framework] << "\n";
+    std::cout << "Threads: " << config.at("Inference").at("Threads").get<int>() << "\n";
+    std::cout << "Detectors: " << pool_size << "\n";
+    std::cout << "Model name: " << model_path << "\n";
+
+    // --- Load detectors
+    // the model is loaded once and shared by the pool if the framework supports it
+    std::vector<std::unique_ptr<Infer::BaseDetector>> detectors = Infer::CreateDetectors(config, model_path, pool_size);
+    if (detectors.empty())
+    {
+        std::cout << "Failed to initialize framework\n";
+        return 1;
+    }
+    Infer::DetectorPool pool;
+    for (auto &detector : detectors)
+        pool.Add(std::move(detector));
+
+    // the reloaded model replaces the pool once warmed up, leased detectors finish their jobs first
+    Infer::ModelReloader reloader;
+    // size and format of the last request, new detectors are warmed up on a frame like it
+    std::mutex warmup_mutex;
+    int warmup_rows = config.at("YOLOv5").at("TargetSize").get<int>();
+    int warmup_cols = warmup_rows;
+    Infer::PixelFormat warmup_format = Infer::PixelFormat::BGR;
+    const auto &reload_config = config.at("HotReload");
+    const bool hot_reload = reload_config.at("Enable").get<bool>();
+    if (hot_reload)
+    {
+        reloader.Start(
+            model_path,
+            reload_config.at("WatchFiles").get<bool>(),
+            reload_config.at("PollMs").get<int>(),
+            [&config, &model_path, pool_size]() { return Infer::CreateDetectors(config, model_path, pool_size); },
+            [&](Infer::BaseDetector &detector) {
+                cv::Mat frame;
+                Infer::PixelFormat format;
+                {
+                    std::lock_guard<std::mutex> lock(warmup_mutex);
+                    frame = CreateWarmupFrame(warmup_rows, warmup_cols, warmup_format);
+                    format = warmup_format;
+                }
+                detector.Detect(frame, format);
+            },
+            [&pool](std::vector<std::unique_ptr<Infer::BaseDetector>> detectors) { pool.Replace(std::move(detectors)); }
+        );
+        g_reloader = &reloader;
+    }
+
+    // thresholds, detection limits, class filter and labels follow the config file,
+    // leased detectors get them when they are returned
+    Infer::ConfigWatcher config_watcher;
+    const auto &live_config = config.at("LiveConfig");
+    if (config_watcher.Start(
+        config_path,
+        config,
+        live_config.at("Enable").get<bool>(),
+        live_config.at("PollMs").get<int>(),
+        [&pool](std::shared_ptr<const Infer::LiveSettings> settings) {
+            pool.Update([settings](Infer::BaseDetector &detector) {
+                detector.SetPostprocessSettings(settings->postprocess);
+            });
+        }
+    ) == false)
+        return 1;
+
+    Infer::DetectService service(
+        pool,
+        server_config.at("MaxQueue").get<size_t>(),
+        server_config.at("MaxBatch").get<int>()
+    );
+    service.Start();
+
+    // --- Serve
+    auto handler = [&](const Infer::HttpRequest &request, Infer::HttpResponse &response) {
+        if (request.path == "/health")
+        {
+            response.body = nlohmann::json{{"status", "ok"}, {"queue", service.GetQueueSize()},
+                {"reloads", reloader.GetReloadCount()}}.dump();
+            return;
+        }
+        if (request.path != "/detect")
+        {
+            SetError(response, 404, "not found");
+            return;
+        }
+        if (request.method != "POST")
+        {
+            SetError(response, 405, "use POST");
+            return;
+        }
+
+        // encoded images are decoded by the workers, raw frames need their format and size
+        Infer::DetectJob job;
+        auto type_it = request.headers.find("content-type");
+        if (type_it != request.headers.end() && type_it->second.rfind("application/octet-stream", 0) == 0)
+        {
+            std::string error = ParseRawFrame(request, job);
+            if (error.empty() == false)
+            {
+                SetError(response, 400, error);
+                return;
+            }
+        }
+        else
+            job.encoded = request.body;
+
+        // reject instead of queueing without bound, clients retry after a while
+        const Infer::PixelFormat format = job.encoded.empty() ? job.format : Infer::PixelFormat::BGR;
+        std::future<Infer::DetectResult> future;
+        if (service.Submit(std::move(job), future) == false)
+        {
+            SetError(response, 503, "busy");
+            response.headers.emplace_back("Retry-After", "1");
+            return;
+        }
+        Infer::DetectResult result = future.get();
+        if (result.ok == false)
+        {
+            SetError(response, 400, "failed to decode image");
+            return;
+        }
+        if (hot_reload)
+        {
+            std::lock_guard<std::mutex> lock(warmup_mutex);
+            warmup_rows = result.img_rows;
+            warmup_cols = result.img_cols;
+            warmup_format = format;
+        }
+
+        std::shared_ptr<const Infer::LiveSettings> settings = config_watcher.Get();
+        const std::vector<std::string> &labels = settings->labels;
+        nlohmann::json objects = nlohmann::json::array();
+        for (const auto &obj : result.objects)
+        {
+            objects.push_back({
+                {"label", obj.label},
+                {"name", obj.label < static_cast<int>(labels.size()) ? labels[obj.label] : ""},
+                {"prob", obj.prob},
+                {"box", {obj.rect.x, obj.rect.y, obj.rect.width, obj.rect.height}}
+            });
+        }
+        response.body = nlohmann::json{
+            {"width", result.img_cols},
+            {"height", result.img_rows},
+            {"objects", objects},
+            {"queue_ms", result.queue_ms},
+            {"elapsed_ms", result.elapsed_ms}
+        }.dump();
+    };
+
+    Infer::HttpServer server;
+    std::string host = server_config.at("Host").get<std::string>();
+    int port = server_config.at("Port").get<int>();
+    if (server.Start(
+        host,
+        port,
+        server_config.at("MaxConnections").get<int>(),
+        server_config.at("MaxBodyMB").get<size_t>() * 1024 * 1024,
+        handler
+    ) == false)
+    {
+        std::cout << "Failed to start server\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+#ifdef SIGHUP
+    if (g_reloader != nullptr)
+        std::signal(SIGHUP, OnReload);
+#endif
+    std::cout << "Listening on http://" << host << ":" << port << "\n";
+    std::cout << "* Press [ctrl+c] to quit *\n";
+
+    while (!g_stop)
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // stop accepting before failing the queued jobs
+    g_reloader = nullptr;
+    reloader.Stop();
+    config_watcher.Stop();
+    server.Stop();
+    service.Stop();
+    std::cout << "Rejected requests: " << service.GetRejectedCount() << "\n";
+
+    return 0;
+}
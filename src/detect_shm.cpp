@@ -0,0 +1,127 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <csignal>
+
+#include <opencv2/opencv.hpp>
+#include "json.hpp"
+
+#include "pipeline/config_loader.hpp"
+#include "pipeline/shm_ring.hpp"
+
+#include "detectors/base_detector.hpp"
+
+static std::atomic<bool> g_stop{false};
+
+void OnSignal(int)
+{
+    g_stop = true;
+}
+
+int main(int argc, char *argv[])
+{
+    // --- Load configs
+    std::string config_path = "../Config.json";
+    nlohmann::json config;
+    if (argc == 2)
+        config_path = std::string(argv[1]);
+    try
+    {
+        std::ifstream config_file(config_path);
+        config = nlohmann::json::parse(config_file, nullptr, true, true);
+    }
+    catch(const nlohmann::json::exception &e)
+    {
+        // std::cout << e.what() << '\n';
+        std::cout << "Failed to read JSON config at " << config_path << "\n";
+        std::cout << "Use `" << argv[0] << " [path_to_config]` to specify a config file.\n";
+        return 1;
+    }
+    // get model path
+    std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
+    int framework = config.at("Inference").at("Framework").get<int>();
+    std::string model_path = Infer::GetModelPath(config, config_path);
+    const auto &shm_config = config.at("SharedMemory");
+    std::string name = shm_config.at("Name").get<std::string>();
+    int pool_size = shm_config.at("PoolSize").get<int>();
+
+    // show configs
+    std::cout << "Using " << support_frameworks[framework] << "\n";
+    std::cout << "Threads: " << config.at("Inference").at("Threads").get<int>() << "\n";
+    std::cout << "Detectors: " << pool_size << "\n";
+    std::cout << "Model name: " << model_path << "\n";
+
+    // --- Load detectors
+    // the model is loaded once and shared by the workers if the framework supports it
+    std::vector<std::unique_ptr<Infer::BaseDetector>> detectors = Infer::CreateDetectors(config, model_path, pool_size);
+    if (detectors.empty())
+    {
+        std::cout << "Failed to initialize framework\n";
+        return 1;
+    }
+
+    // --- Create ring, slots are sized for the largest BGR frame
+    Infer::ShmRing ring;
+    size_t max_frame_bytes = static_cast<size_t>(shm_config.at("MaxWidth").get<int>()) *
+        shm_config.at("MaxHeight").get<int>() * 3;
+    if (ring.Create(
+        name,
+        shm_config.at("Slots").get<int>(),
+        max_frame_bytes,
+        shm_config.at("MaxObjects").get<int>()
+    ) == false)
+    {
+        std::cout << "Failed to create shared memory ring\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::cout << "Serving shared memory " << name << " (" << ring.GetSlotCount() << " slots)\n";
+    std::cout << "* Press [ctrl+c] to quit *\n";
+
+    // --- Run, frames are detected in place and the results are written back into their slots
+    std::atomic<uint64_t> detected{0};
+    std::vector<std::thread> workers;
+    for (auto &detector : detectors)
+    {
+        workers.emplace_back([&ring, &detected, &detector]() {
+            while (!g_stop)
+            {
+                // wake up regularly to notice the stop request
+                int slot = ring.WaitFrame(200);
+                if (slot < 0)
+                    continue;
+                Infer::PixelFormat format;
+                uint64_t frame_id;
+                cv::Mat frame = ring.GetFrame(slot, format, frame_id);
+                // an invalid frame gets empty results so that the producer is not left waiting
+                if (frame.empty())
+                {
+                    ring.PublishResult(slot, {});
+                    continue;
+                }
+                ring.PublishResult(slot, detector->Detect(frame, format));
+                ++detected;
+            }
+        });
+    }
+
+    uint64_t last_detected = 0;
+    while (!g_stop)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t count = detected;
+        std::cout << "Detect: " << count - last_detected << " FPS\n";
+        last_detected = count;
+    }
+
+    for (auto &worker : workers)
+        worker.join();
+
+    return 0;
+}
@@ -1,9 +1,113 @@
 #include "detectors/base_detector.hpp"
+#include "detectors/fast_math.hpp"
 #include <cmath>
+#include <numeric>
+#include <algorithm>
 
 namespace Infer
 {
 
+std::vector<Object> BaseDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    // fallback for frameworks without a fused YUV path: convert on the host
+    cv::Mat bgr;
+    switch (format)
+    {
+        case PixelFormat::BGR:
+            return Detect(frame);
+        case PixelFormat::YUYV:
+            cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_YUYV);
+            break;
+        case PixelFormat::NV12:
+            cv::cvtColor(frame, bgr, cv::COLOR_YUV2BGR_NV12);
+            break;
+    }
+    return Detect(bgr);
+}
+
+std::unique_ptr<BaseDetector> BaseDetector::CreateSharedInstance()
+{
+    return nullptr;
+}
+
+void BaseDetector::CopySettings(const BaseDetector &other)
+{
+    conf_thres_ = other.conf_thres_;
+    nms_thres_ = other.nms_thres_;
+    target_size_ = other.target_size_;
+    max_stride_ = other.max_stride_;
+    num_class_ = other.num_class_;
+    threads_ = other.threads_;
+    isInited_ = other.isInited_;
+    raw_logits_ = other.raw_logits_;
+    max_candidates_ = other.max_candidates_;
+    max_detections_ = other.max_detections_;
+    class_allowed_ = other.class_allowed_;
+    class_indexes_ = other.class_indexes_;
+}
+
+void BaseDetector::SetRawLogits(const bool raw_logits)
+{
+    raw_logits_ = raw_logits;
+}
+
+void BaseDetector::SetConfThreshold(const float conf_thres)
+{
+    conf_thres_ = conf_thres;
+}
+
+float BaseDetector::GetConfThreshold() const
+{
+    return conf_thres_;
+}
+
+bool BaseDetector::SetTargetSize(const int target_size)
+{
+    if (target_size <= 0 || target_size % max_stride_ != 0)
+        return false;
+    target_size_ = target_size;
+    return true;
+}
+
+int BaseDetector::GetTargetSize() const
+{
+    return target_size_;
+}
+
+void BaseDetector::SetDetectionLimits(const int max_candidates, const int max_detections)
+{
+    max_candidates_ = std::max(0, max_candidates);
+    max_detections_ = std::max(0, max_detections);
+}
+
+void BaseDetector::SetClassFilter(const std::vector<int> &class_filter)
+{
+    class_allowed_.clear();
+    class_indexes_.clear();
+    if (class_filter.empty())
+        return;
+    class_allowed_.assign(num_class_, 0);
+    for (const int label : class_filter)
+    {
+        if (label >= 0 && label < num_class_)
+            class_allowed_[label] = 1;
+    }
+    // ascending, so that ties go to the lower index like std::max_element
+    for (int label = 0; label < num_class_; ++label)
+    {
+        if (class_allowed_[label])
+            class_indexes_.push_back(label);
+    }
+}
+
+void BaseDetector::SetPostprocessSettings(const PostprocessSettings &settings)
+{
+    conf_thres_ = settings.conf_thres;
+    nms_thres_ = settings.nms_thres;
+    SetDetectionLimits(settings.max_candidates, settings.max_detections);
+    SetClassFilter(settings.class_filter);
+}
+
 bool BaseDetector::DrawObjects(cv::Mat &image, const std::vector<Object> &objects,
     const std::vector<std::string> &labels, bool isSilent)
 {
@@ -41,77 +145,118 @@ bool BaseDetector::DrawObjects(cv::Mat &image, const std::vector<Object> &object
     return true;
 }
 
-void BaseDetector::GenerateProposals(const float *feat_blob, const std::array<int, 4> nhwc_shape, int stride,
-    const std::array<float, 6> &anchors, std::vector<Object> &proposals)
+void BaseDetector::GenerateProposals(const std::array<FeatureView, 3> &heads, ProposalArena &proposals)
 {
-    proposals.clear();
+    struct Band
+    {
+        int head;
+        int row_begin;
+        int row_end;
+    };
+
+    // split heads into bands of similar cost, so the largest head is shared by several threads
+    size_t total_cells = 0;
+    for (const auto &head : heads)
+        total_cells += static_cast<size_t>(head.nhwc_shape[0]) * head.nhwc_shape[1] * head.nhwc_shape[2];
+    const size_t band_cells = std::max<size_t>(total_cells / (threads_ * 4), 1);
+    std::vector<Band> bands;
+    for (size_t h = 0; h < heads.size(); ++h)
+    {
+        const int rows = heads[h].nhwc_shape[0] * heads[h].nhwc_shape[1];
+        const int band_rows = threads_ == 1 ? rows :
+            std::max(1, static_cast<int>(band_cells / std::max(heads[h].nhwc_shape[2], 1)));
+        for (int row = 0; row < rows; row += band_rows)
+            bands.push_back({static_cast<int>(h), row, std::min(row + band_rows, rows)});
+    }
+
+    // sigmoid is monotonic, so raw logits are compared against the threshold converted once
+    conf_logit_ = Logit(conf_thres_);
+
+    // each band writes to its own arena, no locking needed
+    if (band_proposals_.size() < bands.size())
+        band_proposals_.resize(bands.size());
+    const int num_bands = static_cast<int>(bands.size());
+    #pragma omp parallel for schedule(dynamic) num_threads(threads_)
+    for (int t = 0; t < num_bands; ++t)
+    {
+        const Band &band = bands[t];
+        band_proposals_[t].Clear();
+        GenerateProposals(heads[band.head], band.row_begin, band.row_end,
+            strides_[band.head], anchors_[band.head], band_proposals_[t]);
+    }
 
-    const int batches = nhwc_shape[0];
-    const int num_grid_y = nhwc_shape[1];
-    const int num_grid_x = nhwc_shape[2];
-    const int num_ch = nhwc_shape[3];
+    // merge in band order so that results do not depend on thread timing
+    proposals.Clear();
+    for (int t = 0; t < num_bands; ++t)
+        proposals.Append(band_proposals_[t]);
+}
+
+void BaseDetector::GenerateProposals(const FeatureView &head, const int row_begin, const int row_end,
+    int stride, const std::array<float, 6> &anchors, ProposalArena &proposals)
+{
+    const int num_grid_y = head.nhwc_shape[1];
+    const int num_grid_x = head.nhwc_shape[2];
+    const int num_ch = head.nhwc_shape[3];
     const int num_anchors = anchors.size() / 2;
     const int walk = num_ch / num_anchors;
     const int num_class = walk - 5;
-    for (int b = 0; b < batches; ++b)
+    // sigmoid(obj) * sigmoid(cls) >= conf_thres_ requires sigmoid(obj) >= conf_thres_
+    const float obj_thres = raw_logits_ ? conf_logit_ : conf_thres_;
+    for (int row = row_begin; row < row_end; ++row)
     {
-        const float *ptr1 = feat_blob + b * (num_grid_y * num_grid_x * num_ch);
-        for (int i = 0; i < num_grid_y; ++i)
+        const int i = row % num_grid_y;
+        const float *ptr2 = head.data + row * head.row_step;
+        for (int j = 0; j < num_grid_x; ++j)
         {
-            const float *ptr2 = ptr1 + i * (num_grid_x * num_ch);
-            for (int j = 0; j < num_grid_x; ++j)
+            const float *ptr3 = ptr2 + j * num_ch;
+            for (int k = 0; k < num_anchors; ++k)
             {
-                const float *ptr3 = ptr2 + j * num_ch;
-                for (int k = 0; k < num_anchors; ++k)
+                const float *ptr = ptr3 + k * walk;
+                if (ptr[4] < obj_thres)
+                    continue;
+
+                // NMS is class-agnostic, so only the best class of an anchor can survive
+                const float *class_scores = ptr + 5;
+                int class_index = 0;
+                if (class_indexes_.empty())
+                    class_index = static_cast<int>(
+                        std::max_element(class_scores, class_scores + num_class) - class_scores
+                    );
+                else
                 {
-                    const float anchor_w = anchors[k * 2];
-                    const float anchor_h = anchors[k * 2 + 1];
-                    const float *ptr = ptr3 + k * walk;
-                    float box_conf = ptr[4];
-                    if (box_conf >= conf_thres_)
+                    // only the allowed classes are scanned
+                    class_index = class_indexes_[0];
+                    for (size_t c = 1; c < class_indexes_.size(); ++c)
                     {
-                        // find class index with max class score
-                        int class_index = 0;
-                        float class_score = -FLT_MAX;
-                        for (int c = 0; c < num_class; ++c)
-                        {
-                            float score = ptr[5 + c];
-                            if (score > class_score)
-                            {
-                                class_index = c;
-                                class_score = score;
-                            }
-                            float confidence = box_conf * score;
-
-                            if (confidence >= conf_thres_)
-                            {
-                                float dx = ptr[0];
-                                float dy = ptr[1];
-                                float dw = ptr[2];
-                                float dh = ptr[3];
-
-                                float pb_cx = (dx * 2.0f - 0.5f + j) * stride;
-                                float pb_cy = (dy * 2.0f - 0.5f + i) * stride;
-                                float pb_w = powf(dw * 2.0f, 2) * anchor_w;
-                                float pb_h = powf(dh * 2.0f, 2) * anchor_h;
-
-                                float x0 = pb_cx - pb_w * 0.5f;
-                                float y0 = pb_cy - pb_h * 0.5f;
-                                float x1 = pb_cx + pb_w * 0.5f;
-                                float y1 = pb_cy + pb_h * 0.5f;
-
-                                Object obj;
-                                obj.rect.x = x0;
-                                obj.rect.y = y0;
-                                obj.rect.width = x1 - x0;
-                                obj.rect.height = y1 - y0;
-                                obj.label = class_index;
-                                obj.prob = confidence;
-                                proposals.emplace_back(obj);
-                            }
-                        }
+                        if (class_scores[class_indexes_[c]] > class_scores[class_index])
+                            class_index = class_indexes_[c];
                     }
                 }
+                // only anchors passing the objectness test pay for sigmoid
+                float values[6] = {ptr[0], ptr[1], ptr[2], ptr[3], ptr[4], class_scores[class_index]};
+                if (raw_logits_)
+                    FastSigmoid(values, 6);
+                float confidence = values[4] * values[5];
+                if (confidence < conf_thres_)
+                    continue;
+
+                const float anchor_w = anchors[k * 2];
+                const float anchor_h = anchors[k * 2 + 1];
+                float dx = values[0];
+                float dy = values[1];
+                float dw = values[2];
+                float dh = values[3];
+
+                float pb_cx = (dx * 2.0f - 0.5f + j) * stride;
+                float pb_cy = (dy * 2.0f - 0.5f + i) * stride;
+                float pb_w = powf(dw * 2.0f, 2) * anchor_w;
+                float pb_h = powf(dh * 2.0f, 2) * anchor_h;
+
+                proposals.Push(
+                    pb_cx - pb_w * 0.5f, pb_cy - pb_h * 0.5f,
+                    pb_cx + pb_w * 0.5f, pb_cy + pb_h * 0.5f,
+                    confidence, class_index
+                );
             }
         }
     }
@@ -136,54 +281,187 @@ void BaseDetector::GetLetterboxDimensions(const int img_rows, const int img_cols
     }
 }
 
-void BaseDetector::NMS(std::vector<Object> &proposals, std::vector<Object> &objects,
+void BaseDetector::GetImageSize(const cv::Mat &frame, const PixelFormat format, int &img_rows, int &img_cols)
+{
+    img_rows = format == PixelFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
+    img_cols = frame.cols;
+}
+
+void BaseDetector::LetterboxYUV(const cv::Mat &frame, const PixelFormat format,
+    const int resize_rows, const int resize_cols, const int pad_rows, const int pad_cols,
+    const std::array<float *, 3> &planes)
+{
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    const int out_cols = resize_cols + pad_cols;
+    const int out_size = (resize_rows + pad_rows) * out_cols;
+    const int top = pad_rows / 2;
+    const int left = pad_cols / 2;
+    for (float *plane : planes)
+        std::fill(plane, plane + out_size, 114.0f / 255.0f);
+
+    // horizontal sampling positions are shared by all rows
+    std::vector<int> xs0(resize_cols), xs1(resize_cols);
+    std::vector<float> fxs(resize_cols);
+    const float scale_x = static_cast<float>(img_cols) / resize_cols;
+    for (int dx = 0; dx < resize_cols; ++dx)
+    {
+        float sx = Clamp((dx + 0.5f) * scale_x - 0.5f, 0.0f, static_cast<float>(img_cols - 1));
+        xs0[dx] = static_cast<int>(sx);
+        xs1[dx] = std::min(xs0[dx] + 1, img_cols - 1);
+        fxs[dx] = sx - xs0[dx];
+    }
+
+    const float scale_y = static_cast<float>(img_rows) / resize_rows;
+    #pragma omp parallel for num_threads(threads_)
+    for (int dy = 0; dy < resize_rows; ++dy)
+    {
+        float sy = Clamp((dy + 0.5f) * scale_y - 0.5f, 0.0f, static_cast<float>(img_rows - 1));
+        const int y0 = static_cast<int>(sy);
+        const int y1 = std::min(y0 + 1, img_rows - 1);
+        const float fy = sy - y0;
+        // chroma has half resolution, so it is sampled from the nearest pixel
+        const int yc = std::min(static_cast<int>(sy + 0.5f), img_rows - 1);
+        const unsigned char *row0 = frame.ptr<unsigned char>(y0);
+        const unsigned char *row1 = frame.ptr<unsigned char>(y1);
+        const unsigned char *row_c = format == PixelFormat::NV12 ?
+            frame.ptr<unsigned char>(img_rows + yc / 2) : frame.ptr<unsigned char>(yc);
+        // YUYV stores Y at even bytes, NV12 stores Y in its own plane
+        const int y_step = format == PixelFormat::YUYV ? 2 : 1;
+
+        const int offset = (top + dy) * out_cols + left;
+        for (int dx = 0; dx < resize_cols; ++dx)
+        {
+            const int x0 = xs0[dx] * y_step;
+            const int x1 = xs1[dx] * y_step;
+            const float fx = fxs[dx];
+            const float top_y = row0[x0] + (row0[x1] - row0[x0]) * fx;
+            const float bottom_y = row1[x0] + (row1[x1] - row1[x0]) * fx;
+            const float y = top_y + (bottom_y - top_y) * fy;
+
+            // both formats store a U, V pair for every two pixels
+            const int xc = (std::min(static_cast<int>(fxs[dx] + 0.5f) + xs0[dx], img_cols - 1) & ~1) * y_step;
+            const float u = format == PixelFormat::YUYV ? row_c[xc + 1] : row_c[xc];
+            const float v = format == PixelFormat::YUYV ? row_c[xc + 3] : row_c[xc + 1];
+
+            // BT.601 limited range, same as cv::COLOR_YUV2BGR_*
+            const float luma = 1.164f * (y - 16.0f);
+            const float r = luma + 1.596f * (v - 128.0f);
+            const float g = luma - 0.813f * (v - 128.0f) - 0.391f * (u - 128.0f);
+            const float b = luma + 2.018f * (u - 128.0f);
+            planes[0][offset + dx] = Clamp(r, 0.0f, 255.0f) * (1 / 255.0f);
+            planes[1][offset + dx] = Clamp(g, 0.0f, 255.0f) * (1 / 255.0f);
+            planes[2][offset + dx] = Clamp(b, 0.0f, 255.0f) * (1 / 255.0f);
+        }
+    }
+}
+
+void BaseDetector::NMS(const ProposalArena &proposals, std::vector<Object> &objects,
     const int orig_h, const int orig_w,
     const float dh, const float dw, const float ratio_h, const float ratio_w)
 {
     objects.clear();
-    std::vector<cv::Rect> boxes;
-    std::vector<float> scores;
-    std::vector<int> labels;
-    std::vector<int> indices;
+    kept_.Clear();
 
-    for (const auto &prop : proposals)
+    // greedy NMS from the highest score, ties keep decoding order like cv::dnn::NMSBoxes
+    auto by_score = [&proposals](const int a, const int b) {
+        return proposals.score[a] > proposals.score[b] ||
+            (proposals.score[a] == proposals.score[b] && a < b);
+    };
+    order_.resize(proposals.Size());
+    std::iota(order_.begin(), order_.end(), 0);
+    // keep only the best candidates, selecting them is linear while NMS is quadratic
+    if (max_candidates_ > 0 && order_.size() > static_cast<size_t>(max_candidates_))
     {
-        boxes.emplace_back(prop.rect);
-        scores.emplace_back(prop.prob);
-        labels.emplace_back(prop.label);
+        std::nth_element(order_.begin(), order_.begin() + max_candidates_, order_.end(), by_score);
+        order_.resize(max_candidates_);
     }
+    std::sort(order_.begin(), order_.end(), by_score);
 
-    cv::dnn::NMSBoxes(boxes, scores, conf_thres_, nms_thres_, indices);
-
-    for (const auto i : indices)
+    for (const int i : order_)
     {
-        const auto &box = boxes[i];
-        float x0 = box.x;
-        float y0 = box.y;
-        float x1 = box.x + box.width;
-        float y1 = box.y + box.height;
-        const float &score = scores[i];
-        const int &label = labels[i];
+        if (max_detections_ > 0 && kept_.Size() >= static_cast<size_t>(max_detections_))
+            break;
+
+        const float x0 = proposals.x0[i];
+        const float y0 = proposals.y0[i];
+        const float x1 = proposals.x1[i];
+        const float y1 = proposals.y1[i];
+        const float area = (x1 - x0) * (y1 - y0);
+
+        // kept boxes are stored contiguously, so the overlap test against all of them vectorizes
+        const float *kx0 = kept_.x0.data();
+        const float *ky0 = kept_.y0.data();
+        const float *kx1 = kept_.x1.data();
+        const float *ky1 = kept_.y1.data();
+        const int num_kept = static_cast<int>(kept_.Size());
+        float max_iou = 0.0f;
+        #pragma omp simd reduction(max:max_iou)
+        for (int k = 0; k < num_kept; ++k)
+        {
+            const float inter_w = std::max(0.0f, std::min(x1, kx1[k]) - std::max(x0, kx0[k]));
+            const float inter_h = std::max(0.0f, std::min(y1, ky1[k]) - std::max(y0, ky0[k]));
+            const float inter = inter_w * inter_h;
+            const float kept_area = (kx1[k] - kx0[k]) * (ky1[k] - ky0[k]);
+            max_iou = std::max(max_iou, inter / (area + kept_area - inter));
+        }
+
+        if (max_iou <= nms_thres_)
+            kept_.Push(x0, y0, x1, y1, proposals.score[i], proposals.label[i]);
+    }
 
-        x0 = (x0 - dw) / ratio_w;
-        y0 = (y0 - dh) / ratio_h;
-        x1 = (x1 - dw) / ratio_w;
-        y1 = (y1 - dh) / ratio_h;
+    objects.reserve(kept_.Size());
+    for (size_t k = 0; k < kept_.Size(); ++k)
+    {
+        Object obj;
+        obj.rect = UnletterboxBox(kept_.x0[k], kept_.y0[k], kept_.x1[k], kept_.y1[k],
+            orig_h, orig_w, dh, dw, ratio_h, ratio_w);
+        obj.prob = kept_.score[k];
+        obj.label = kept_.label[k];
+        objects.emplace_back(obj);
+    }
+}
 
-        x0 = Clamp(x0, 0.0f, static_cast<float>(orig_w));
-        y0 = Clamp(y0, 0.0f, static_cast<float>(orig_h));
-        x1 = Clamp(x1, 0.0f, static_cast<float>(orig_w));
-        y1 = Clamp(y1, 0.0f, static_cast<float>(orig_h));
+void BaseDetector::ParseDetections(const float *detections, const int count, std::vector<Object> &objects,
+    const int orig_h, const int orig_w,
+    const float dh, const float dw, const float ratio_h, const float ratio_w)
+{
+    objects.clear();
+    for (int i = 0; i < count; ++i)
+    {
+        if (max_detections_ > 0 && objects.size() >= static_cast<size_t>(max_detections_))
+            break;
+        const float *det = detections + i * 6;
+        if (det[4] < conf_thres_)
+            continue;
+        const int label = static_cast<int>(det[5]);
+        if (!class_allowed_.empty() && (label < 0 || label >= num_class_ || class_allowed_[label] == 0))
+            continue;
 
         Object obj;
-        obj.rect.x = x0;
-        obj.rect.y = y0;
-        obj.rect.width = x1 - x0;
-        obj.rect.height = y1 - y0;
-        obj.prob = score;
+        obj.rect = UnletterboxBox(det[0], det[1], det[2], det[3],
+            orig_h, orig_w, dh, dw, ratio_h, ratio_w);
+        obj.prob = det[4];
         obj.label = label;
         objects.emplace_back(obj);
     }
 }
 
+cv::Rect_<float> BaseDetector::UnletterboxBox(float x0, float y0, float x1, float y1,
+    const int orig_h, const int orig_w,
+    const float dh, const float dw, const float ratio_h, const float ratio_w)
+{
+    x0 = (x0 - dw) / ratio_w;
+    y0 = (y0 - dh) / ratio_h;
+    x1 = (x1 - dw) / ratio_w;
+    y1 = (y1 - dh) / ratio_h;
+
+    x0 = Clamp(x0, 0.0f, static_cast<float>(orig_w));
+    y0 = Clamp(y0, 0.0f, static_cast<float>(orig_h));
+    x1 = Clamp(x1, 0.0f, static_cast<float>(orig_w));
+    y1 = Clamp(y1, 0.0f, static_cast<float>(orig_h));
+
+    return cv::Rect_<float>(x0, y0, x1 - x0, y1 - y0);
+}
+
 }   // namespace Infer
@@ -1,4 +1,6 @@
 #include "detectors/cv_detector.hpp"
+#include <filesystem>
+#include <algorithm>
 
 namespace Infer
 {
@@ -26,10 +28,14 @@ std::vector<Object> CVDetector::Detect(const cv::Mat &bgr)
     // OpenCV needs to know input shapes ahead of inference so that memory can be allocated.
     // Therefore, dynamic height and width are not supported by the current dnn engine.
     // Reference: https://github.com/opencv/opencv/issues/19347#issuecomment-1868227401
+    // Instead, pad to the smallest fixed-shape bucket that fits the resized image.
     GetLetterboxDimensions(
-        img_rows, img_cols, false,
+        img_rows, img_cols, true,
         resize_rows, resize_cols, pad_rows, pad_cols, scale
     );
+    ShapeBucket &bucket = SelectBucket(resize_rows, resize_cols);
+    pad_rows = bucket.size.height - resize_rows;
+    pad_cols = bucket.size.width - resize_cols;
     cv::Mat letterbox, blob;
     cv::resize(bgr, letterbox, cv::Size(resize_cols, resize_rows), 0, 0, cv::INTER_AREA);
     cv::copyMakeBorder(
@@ -40,11 +46,47 @@ std::vector<Object> CVDetector::Detect(const cv::Mat &bgr)
     );
     cv::dnn::blobFromImage(letterbox, blob, 1.0 / 255.0, cv::Size(letterbox.cols, letterbox.rows), cv::Scalar(), true, false);
 
+    return Run(blob, bucket, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> CVDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    if (format == PixelFormat::BGR)
+        return Detect(frame);
+    if (isInited_ == false)
+        return {};
+
+    // --- preprocessing
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    float scale;
+    int resize_rows, resize_cols, pad_rows, pad_cols;
+    GetLetterboxDimensions(
+        img_rows, img_cols, true,
+        resize_rows, resize_cols, pad_rows, pad_cols, scale
+    );
+    ShapeBucket &bucket = SelectBucket(resize_rows, resize_cols);
+    pad_rows = bucket.size.height - resize_rows;
+    pad_cols = bucket.size.width - resize_cols;
+    // fused letterbox straight from YUV
+    const int rows = bucket.size.height;
+    const int cols = bucket.size.width;
+    cv::Mat blob(std::vector<int>{1, 3, rows, cols}, CV_32F);
+    float *data = blob.ptr<float>();
+    LetterboxYUV(frame, format, resize_rows, resize_cols, pad_rows, pad_cols,
+        {data, data + rows * cols, data + 2 * rows * cols});
+
+    return Run(blob, bucket, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> CVDetector::Run(const cv::Mat &blob, ShapeBucket &bucket, const int img_rows, const int img_cols,
+    const int pad_rows, const int pad_cols, const float scale)
+{
     // --- Model inference
-    net_.setInput(blob);
-    std::vector<cv::String> outputNames = net_.getUnconnectedOutLayersNames();
+    bucket.net.setInput(blob);
+    std::vector<cv::String> outputNames = bucket.net.getUnconnectedOutLayersNames();
     std::vector<cv::Mat> outputs;
-    net_.forward(outputs, outputNames);
+    bucket.net.forward(outputs, outputNames);
 
     // --- Postprocessing
     // ensure they are in descending order of size: 80x80, 40x40, 20x20
@@ -52,20 +94,20 @@ std::vector<Object> CVDetector::Detect(const cv::Mat &bgr)
         return std::max(a.size[1], a.size[2]) > std::max(b.size[1], b.size[2]);
     });
 
-    std::vector<Object> proposals, objects;
-    for (size_t i = 0; i < outputs.size(); ++i)
+    std::vector<Object> objects;
+    std::array<FeatureView, 3> heads;
+    for (size_t i = 0; i < heads.size(); ++i)
     {
         cv::Mat &output = outputs[i];
-        std::vector<Object> temp;
-        GenerateProposals(
+        heads[i] = {
             (float *)output.data,
             {output.size[0], output.size[1], output.size[2], output.size[3]},
-            strides_[i], anchors_[i], temp
-        );
-        proposals.insert(proposals.end(), temp.begin(), temp.end());
+            static_cast<size_t>(output.size[2]) * output.size[3]
+        };
     }
+    GenerateProposals(heads, proposals_);
 
-    NMS(proposals, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
+    NMS(proposals_, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
 
     return objects;
 }
@@ -74,27 +116,97 @@ bool CVDetector::Initialize(const int threads, const std::string &model_path,
     const float conf_thres, const float nms_thres,
     const int target_size, const int max_stride, const int num_class)
 {
-    try
-    {
-        net_ = cv::dnn::readNet(model_path + ".onnx");
-    }
-    catch (const cv::Exception &e)
-    {
-        std::cout << "Failed to load model: " << e.what() << "\n";
+    target_size_ = target_size;
+    max_stride_ = max_stride;
+    model_path_ = model_path;
+    buckets_.clear();
+    if (LoadBuckets(target_size_) == false)
         return false;
-    }
-    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-    cv::setNumThreads(std::max(1, threads));
+    threads_ = std::max(1, threads);
+    cv::setNumThreads(threads_);
 
     conf_thres_ = conf_thres;
     nms_thres_ = nms_thres;
-    target_size_ = target_size;
-    max_stride_ = max_stride;
     num_class_ = num_class;
 
     isInited_ = true;
     return true;
 }
 
+bool CVDetector::SetTargetSize(const int target_size)
+{
+    // smaller sizes are padded to the smallest loaded bucket that fits, larger ones have no bucket
+    if (buckets_.empty() || target_size > buckets_.front().size.width)
+        return false;
+    if (BaseDetector::SetTargetSize(target_size) == false)
+        return false;
+    // fixed-shape exports for this size are loaded once and kept, so switching back is free
+    LoadBuckets(target_size);
+    return true;
+}
+
+bool CVDetector::LoadBuckets(const int target_size)
+{
+    // common aspect ratios (short side / long side) of camera frames and images: 1:1, 4:3 and 16:9
+    const std::array<float, 3> ratios = {1.0f, 3.0f / 4.0f, 9.0f / 16.0f};
+
+    // the first square bucket defines the largest supported target size
+    const bool first = buckets_.empty();
+    for (const float ratio : ratios)
+    {
+        int short_side = static_cast<int>(std::round(target_size * ratio));
+        short_side = (short_side + max_stride_ - 1) / max_stride_ * max_stride_;
+        std::vector<cv::Size> sizes = {cv::Size(target_size, short_side)};
+        if (short_side != target_size)
+            sizes.emplace_back(short_side, target_size);
+
+        for (const auto &size : sizes)
+        {
+            if (std::any_of(buckets_.begin(), buckets_.end(),
+                [&size](const ShapeBucket &bucket) { return bucket.size == size; }))
+                continue;
+
+            // the first square bucket uses the regular model, the others are fixed-shape exports
+            // named after their input size, e.g. yolov5n_384x640.onnx (height x width)
+            std::string path = model_path_ + ".onnx";
+            if (first == false || size.width != size.height)
+            {
+                path = model_path_ + "_" + std::to_string(size.height) + "x" + std::to_string(size.width) + ".onnx";
+                if (std::filesystem::exists(path) == false)
+                    continue;
+            }
+
+            ShapeBucket bucket;
+            bucket.size = size;
+            try
+            {
+                bucket.net = cv::dnn::readNet(path);
+            }
+            catch (const cv::Exception &e)
+            {
+                std::cout << "Failed to load model: " << e.what() << "\n";
+                return false;
+            }
+            bucket.net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            bucket.net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            buckets_.emplace_back(std::move(bucket));
+        }
+    }
+
+    return buckets_.empty() == false;
+}
+
+CVDetector::ShapeBucket & CVDetector::SelectBucket(const int resize_rows, const int resize_cols)
+{
+    // the square bucket always fits since the long side of the resized image is at most its size
+    ShapeBucket *best = &buckets_.front();
+    for (auto &bucket : buckets_)
+    {
+        if (bucket.size.height >= resize_rows && bucket.size.width >= resize_cols &&
+            bucket.size.area() < best->size.area())
+            best = &bucket;
+    }
+    return *best;
+}
+
 }   // namespace Infer
\ No newline at end of file
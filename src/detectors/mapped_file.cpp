@@ -0,0 +1,76 @@
+#include "detectors/mapped_file.hpp"
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Infer
+{
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    data_ = data;
+    size_ = static_cast<size_t>(st.st_size);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (buffer_.empty())
+        return false;
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifndef _WIN32
+    if (data_ != nullptr)
+        munmap(data_, size_);
+#else
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+const unsigned char * MappedFile::Data() const
+{
+    return static_cast<const unsigned char *>(data_);
+}
+
+size_t MappedFile::Size() const
+{
+    return size_;
+}
+
+}   // namespace Infer
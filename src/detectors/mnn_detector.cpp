@@ -3,14 +3,19 @@
 namespace Infer
 {
 
-MNNDetector::MNNDetector()
+MNNDetector::MNNDetector(const bool memory_map)
+    : memory_map_(memory_map)
 {
 
 }
 
 MNNDetector::~MNNDetector()
 {
-
+    std::lock_guard<std::mutex> lock(*net_mutex_);
+    if (sessions_.empty() && session_ != nullptr)
+        net_->releaseSession(session_);
+    for (const auto &[shape, session] : sessions_)
+        net_->releaseSession(session);
 }
 
 std::vector<Object> MNNDetector::Detect(const cv::Mat &bgr)
@@ -40,40 +45,85 @@ std::vector<Object> MNNDetector::Detect(const cv::Mat &bgr)
     letterbox.convertTo(letterbox, CV_32FC3, 1.0 / 255.0);
     // create input tensor
     std::vector<int> dims{1, letterbox.rows, letterbox.cols, 3};
-    auto nhwc_tensor = MNN::Tensor::create<float>(dims, nullptr, MNN::Tensor::TENSORFLOW); // data format: NHWC
+    std::unique_ptr<MNN::Tensor> nhwc_tensor(
+        MNN::Tensor::create<float>(dims, nullptr, MNN::Tensor::TENSORFLOW) // data format: NHWC
+    );
     auto nhwc_data = nhwc_tensor->host<float>();
     auto nhwc_size = nhwc_tensor->size();
     std::memcpy(nhwc_data, letterbox.data, nhwc_size);
 
-    auto input_tensor = net_->getSessionInput(session_, nullptr);
-    net_->resizeTensor(input_tensor, {1, 3, letterbox.rows, letterbox.cols});
-    net_->resizeSession(session_);
-    input_tensor->copyFromHostTensor(nhwc_tensor);
+    return Run(nhwc_tensor.get(), img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> MNNDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    if (format == PixelFormat::BGR)
+        return Detect(frame);
+    if (isInited_ == false)
+        return {};
+
+    // --- Preprocessing
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    float scale;
+    int resize_rows, resize_cols, pad_rows, pad_cols;
+    GetLetterboxDimensions(
+        img_rows, img_cols, true,
+        resize_rows, resize_cols, pad_rows, pad_cols, scale
+    );
+    // fused letterbox straight from YUV
+    const int rows = resize_rows + pad_rows;
+    const int cols = resize_cols + pad_cols;
+    std::vector<int> dims{1, 3, rows, cols};
+    std::unique_ptr<MNN::Tensor> nchw_tensor(
+        MNN::Tensor::create<float>(dims, nullptr, MNN::Tensor::CAFFE) // data format: NCHW
+    );
+    float *nchw_data = nchw_tensor->host<float>();
+    LetterboxYUV(frame, format, resize_rows, resize_cols, pad_rows, pad_cols,
+        {nchw_data, nchw_data + rows * cols, nchw_data + 2 * rows * cols});
+
+    return Run(nchw_tensor.get(), img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> MNNDetector::Run(const MNN::Tensor *host_tensor, const int img_rows, const int img_cols,
+    const int pad_rows, const int pad_cols, const float scale)
+{
+    const int rows = host_tensor->getDimensionType() == MNN::Tensor::TENSORFLOW ?
+        host_tensor->shape()[1] : host_tensor->shape()[2];
+    const int cols = host_tensor->getDimensionType() == MNN::Tensor::TENSORFLOW ?
+        host_tensor->shape()[2] : host_tensor->shape()[3];
+    MNN::Session *session = GetSession(rows, cols);
+    if (session == nullptr)
+        return {};
+    auto input_tensor = net_->getSessionInput(session, nullptr);
+    input_tensor->copyFromHostTensor(host_tensor);
 
     // --- Model inference
-    net_->runSession(session_);
+    net_->runSession(session);
 
-    std::vector<Object> proposals, objects;
-    for (size_t i = 0; i < strides_.size(); ++i)
+    std::vector<Object> objects;
+    std::array<std::unique_ptr<MNN::Tensor>, 3> out_hosts;
+    std::array<FeatureView, 3> heads;
+    for (size_t i = 0; i < heads.size(); ++i)
     {
         // get outputs
-        MNN::Tensor *out = net_->getSessionOutput(session_, output_names_[i].c_str());
+        MNN::Tensor *out = net_->getSessionOutput(session, output_names_[i].c_str());
         // create tensions with the same shape as given tensions
-        MNN::Tensor out_host(out, out->getDimensionType());
+        out_hosts[i] = std::make_unique<MNN::Tensor>(out, out->getDimensionType());
         // save outputs
-        out->copyToHostTensor(&out_host);
+        out->copyToHostTensor(out_hosts[i].get());
 
-        std::vector<Object> temp;
-        GenerateProposals(
+        const MNN::Tensor &out_host = *out_hosts[i];
+        heads[i] = {
             out_host.host<float>(),
             {out_host.shape()[0], out_host.shape()[1], out_host.shape()[2], out_host.shape()[3]},
-            strides_[i], anchors_[i], temp
-        );
-        proposals.insert(proposals.end(), temp.begin(), temp.end());
+            static_cast<size_t>(out_host.shape()[2]) * out_host.shape()[3]
+        };
     }
+    GenerateProposals(heads, proposals_);
 
     // --- Postprocessing
-    NMS(proposals, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
+    NMS(proposals_, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
 
     return objects;
 }
@@ -82,40 +132,99 @@ bool MNNDetector::Initialize(const int threads, const std::string &model_path,
     const float conf_thres, const float nms_thres,
     const int target_size, const int max_stride, const int num_class)
 {
-    net_ = std::unique_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(
-        (model_path + ".mnn").c_str()
-    ));
+    if (memory_map_)
+    {
+        // MNN keeps its own copy of the model, the mapping only replaces the staging read buffer
+        // so that cold starts read the file straight from the shared page cache
+        MappedFile model_file;
+        if (model_file.Open(model_path + ".mnn") == false)
+            return false;
+        net_ = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromBuffer(
+            model_file.Data(), model_file.Size()
+        ));
+    }
+    else
+    {
+        net_ = std::shared_ptr<MNN::Interpreter>(MNN::Interpreter::createFromFile(
+            (model_path + ".mnn").c_str()
+        ));
+    }
     if (net_ == nullptr)
         return false;
 
+    threads_ = std::max(1, threads);
+    session_ = CreateSession();
+    if (session_ == nullptr)
+        return false;
+
+    conf_thres_ = conf_thres;
+    nms_thres_ = nms_thres;
+    target_size_ = target_size;
+    max_stride_ = max_stride;
+    num_class_ = num_class;
+
+    isInited_ = true;
+    return true;
+}
+
+std::unique_ptr<BaseDetector> MNNDetector::CreateSharedInstance()
+{
+    if (isInited_ == false)
+        return nullptr;
+
+    auto detector = std::make_unique<MNNDetector>(memory_map_);
+    detector->net_ = net_;
+    detector->net_mutex_ = net_mutex_;
+    detector->CopySettings(*this);
+    detector->session_ = detector->CreateSession();
+    if (detector->session_ == nullptr)
+        return nullptr;
+    return detector;
+}
+
+MNN::Session * MNNDetector::CreateSession()
+{
     MNN::ScheduleConfig config;
-    config.numThread = std::max(1, threads);
+    config.numThread = threads_;
     // change to MNN_FORWARD_AUTO to enable backend acceleration
     config.type = static_cast<MNNForwardType>(MNN_FORWARD_CPU);
     MNN::BackendConfig backendConfig;
     backendConfig.precision = static_cast<MNN::BackendConfig::PrecisionMode>(MNN::BackendConfig::Precision_Normal);
     config.backendConfig = &backendConfig;
 
-    session_ = net_->createSession(config);
-    if (session_ == nullptr)
-        return false;
+    std::lock_guard<std::mutex> lock(*net_mutex_);
+    MNN::Session *session = net_->createSession(config);
+    if (session == nullptr || output_names_.empty() == false)
+        return session;
 
     // get and sort output names
-    for (const auto &[key, value] : net_->getSessionOutputAll(session_))
+    for (const auto &[key, value] : net_->getSessionOutputAll(session))
         output_names_.push_back(key);
     // ensure they are in descending order of size: 80, 40, 20
     std::sort(output_names_.begin(), output_names_.end(), [](const std::string &a, const std::string &b) {
         return std::atoi(a.c_str()) < std::atoi(b.c_str());
     });
 
-    conf_thres_ = conf_thres;
-    nms_thres_ = nms_thres;
-    target_size_ = target_size;
-    max_stride_ = max_stride;
-    num_class_ = num_class;
+    return session;
+}
 
-    isInited_ = true;
-    return true;
+MNN::Session * MNNDetector::GetSession(const int rows, const int cols)
+{
+    auto it = sessions_.find({rows, cols});
+    if (it != sessions_.end())
+        return it->second;
+
+    // the session from initialization takes the first shape
+    MNN::Session *session = sessions_.empty() ? session_ : CreateSession();
+    if (session == nullptr)
+        return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(*net_mutex_);
+        net_->resizeTensor(net_->getSessionInput(session, nullptr), {1, 3, rows, cols});
+        net_->resizeSession(session);
+    }
+    sessions_.emplace(std::make_pair(rows, cols), session);
+    return session;
 }
 
 }   // namespace Infer
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "detectors/ncnn_detector.hpp"
+#include "datareader.h"
 
 namespace Infer
 {
 
-NCNNDetector::NCNNDetector()
+NCNNDetector::NCNNDetector(const bool memory_map)
+    : memory_map_(memory_map)
 {
 
 }
@@ -27,9 +29,10 @@ std::vector<Object> NCNNDetector::Detect(const cv::Mat &bgr)
         img_rows, img_cols, true,
         resize_rows, resize_cols, pad_rows, pad_cols, scale
     );
-    // letterbox
+    // letterbox, the stride allows cropped views of larger frames
     ncnn::Mat resized = ncnn::Mat::from_pixels_resize(
-        bgr.data, ncnn::Mat::PIXEL_BGR2RGB, img_cols, img_rows, resize_cols, resize_rows
+        bgr.data, ncnn::Mat::PIXEL_BGR2RGB, img_cols, img_rows, static_cast<int>(bgr.step),
+        resize_cols, resize_rows
     );
     ncnn::Mat letterbox;
     ncnn::copy_make_border(
@@ -41,24 +44,56 @@ std::vector<Object> NCNNDetector::Detect(const cv::Mat &bgr)
     const float norm_values[3] = {1 / 255.0f, 1 / 255.0f, 1 / 255.0f};
     letterbox.substract_mean_normalize(0, norm_values);
 
+    return Run(letterbox, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> NCNNDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    if (format == PixelFormat::BGR)
+        return Detect(frame);
+    if (isInited_ == false)
+        return {};
+
+    // --- Preprocessing
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    float scale;
+    int resize_rows, resize_cols, pad_rows, pad_cols;
+    GetLetterboxDimensions(
+        img_rows, img_cols, true,
+        resize_rows, resize_cols, pad_rows, pad_cols, scale
+    );
+    // fused letterbox straight from YUV
+    ncnn::Mat letterbox(resize_cols + pad_cols, resize_rows + pad_rows, 3);
+    LetterboxYUV(frame, format, resize_rows, resize_cols, pad_rows, pad_cols,
+        {letterbox.channel(0), letterbox.channel(1), letterbox.channel(2)});
+
+    return Run(letterbox, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> NCNNDetector::Run(const ncnn::Mat &letterbox, const int img_rows, const int img_cols,
+    const int pad_rows, const int pad_cols, const float scale)
+{
     // --- Model inference
-    std::vector<Object> proposals, objects;
+    std::vector<Object> objects;
 
-    ncnn::Extractor ex = net_.create_extractor();
+    ncnn::Extractor ex = net_->create_extractor();
+    ex.set_num_threads(threads_);
     ex.input("in0", letterbox);
 
     const char *blob_names[] = {"out0", "out1", "out2"};
-    for (size_t i = 0; i < strides_.size(); ++i)
+    std::array<ncnn::Mat, 3> outs;
+    std::array<FeatureView, 3> heads;
+    for (size_t i = 0; i < heads.size(); ++i)
     {
-        ncnn::Mat out;
-        ex.extract(blob_names[i], out);
-        std::vector<Object> temp;
-        GenerateProposals(out, strides_[i], anchors_[i], temp);
-        proposals.insert(proposals.end(), temp.begin(), temp.end());
+        ex.extract(blob_names[i], outs[i]);
+        // ncnn lays the NHWC head out as c = H, h = W, w = C with aligned channel steps
+        heads[i] = {static_cast<const float *>(outs[i].data), {1, outs[i].c, outs[i].h, outs[i].w}, outs[i].cstep};
     }
+    GenerateProposals(heads, proposals_);
 
     // --- Postprocessing
-    NMS(proposals, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
+    NMS(proposals_, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
 
     return objects;
 }
@@ -67,10 +102,24 @@ bool NCNNDetector::Initialize(const int threads, const std::string &model_path,
         const float conf_thres, const float nms_thres,
         const int target_size, const int max_stride, const int num_class)
 {
-    net_.opt.num_threads = std::max(1, threads);
+    threads_ = std::max(1, threads);
+    net_->opt.num_threads = threads_;
 
-    if (net_.load_param((model_path + ".param").c_str()) ||
-        net_.load_model((model_path + ".bin").c_str()))
+    if (net_->load_param((model_path + ".param").c_str()))
+        return false;
+    if (memory_map_)
+    {
+        // weights are referenced in place where possible, only touched pages are read from disk
+        // and the page cache is shared by every process that maps the same file
+        model_file_ = std::make_shared<MappedFile>();
+        if (model_file_->Open(model_path + ".bin") == false)
+            return false;
+        const unsigned char *mem = model_file_->Data();
+        ncnn::DataReaderFromMemory dr(mem);
+        if (net_->load_model(dr))
+            return false;
+    }
+    else if (net_->load_model((model_path + ".bin").c_str()))
         return false;
 
     conf_thres_ = conf_thres;
@@ -83,74 +132,16 @@ bool NCNNDetector::Initialize(const int threads, const std::string &model_path,
     return true;
 }
 
-void NCNNDetector::GenerateProposals(const ncnn::Mat &feat_blob, int stride,
-    const std::array<float, 6> &anchors, std::vector<Object> &proposals)
+std::unique_ptr<BaseDetector> NCNNDetector::CreateSharedInstance()
 {
-    const int num_w = feat_blob.w;
-    const int num_grid_y = feat_blob.c;
-    const int num_grid_x = feat_blob.h;
-
-    const int num_anchors = static_cast<int>(anchors.size()) / 2;
-    const int walk = num_w / num_anchors;
-    const int num_class = walk - 5;
+    if (isInited_ == false)
+        return nullptr;
 
-    for (int i = 0; i < num_grid_y; ++i)
-    {
-        for (int j = 0; j < num_grid_x; ++j)
-        {
-            const float *matat = feat_blob.channel(i).row(j);
-            for (int k = 0; k < num_anchors; ++k)
-            {
-                const float anchor_w = anchors[k * 2];
-                const float anchor_h = anchors[k * 2 + 1];
-                const float *ptr = matat + k * walk;
-                float box_conf = ptr[4];
-                if (box_conf >= conf_thres_)
-                {
-                    // find class index with max class score
-                    int class_index = 0;
-                    float class_score = -FLT_MAX;
-                    for (int c = 0; c < num_class; ++c)
-                    {
-                        float score = ptr[5 + c];
-                        if (score > class_score)
-                        {
-                            class_index = c;
-                            class_score = score;
-                        }
-                        float confidence = box_conf * score;
-
-                        if (confidence >= conf_thres_)
-                        {
-                            float dx = ptr[0];
-                            float dy = ptr[1];
-                            float dw = ptr[2];
-                            float dh = ptr[3];
-
-                            float pb_cx = (dx * 2.0f - 0.5f + j) * stride;
-                            float pb_cy = (dy * 2.0f - 0.5f + i) * stride;
-                            float pb_w = powf(dw * 2.0f, 2) * anchor_w;
-                            float pb_h = powf(dh * 2.0f, 2) * anchor_h;
-
-                            float x0 = pb_cx - pb_w * 0.5f;
-                            float y0 = pb_cy - pb_h * 0.5f;
-                            float x1 = pb_cx + pb_w * 0.5f;
-                            float y1 = pb_cy + pb_h * 0.5f;
-
-                            Object obj;
-                            obj.rect.x = x0;
-                            obj.rect.y = y0;
-                            obj.rect.width = x1 - x0;
-                            obj.rect.height = y1 - y0;
-                            obj.label = class_index;
-                            obj.prob = confidence;
-                            proposals.emplace_back(obj);
-                        }
-                    }
-                }
-            }
-        }
-    }
+    auto detector = std::make_unique<NCNNDetector>(memory_map_);
+    detector->model_file_ = model_file_;
+    detector->net_ = net_;
+    detector->CopySettings(*this);
+    return detector;
 }
 
 }   // namespace Infer
@@ -1,8 +1,31 @@
 #include "detectors/ort_detector.hpp"
+#include <mutex>
+#include <functional>
 
 namespace Infer
 {
 
+namespace
+{
+
+// get the process-wide instance of T, created on first use and released with its last user
+template <typename T>
+std::shared_ptr<T> GetProcessShared(const std::function<std::shared_ptr<T>()> &create)
+{
+    static std::mutex mutex;
+    static std::weak_ptr<T> instance;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<T> shared = instance.lock();
+    if (shared == nullptr)
+    {
+        shared = create();
+        instance = shared;
+    }
+    return shared;
+}
+
+}   // namespace
+
 ORTDetector::ORTDetector()
 {
 
@@ -38,7 +61,40 @@ std::vector<Object> ORTDetector::Detect(const cv::Mat &bgr)
     );
     cv::dnn::blobFromImage(letterbox, blob, 1.0 / 255.0, cv::Size(letterbox.cols, letterbox.rows), cv::Scalar(0, 0, 0), true, false);
 
-    std::vector<int64_t> input_tensor_shape = {1, 3, letterbox.rows, letterbox.cols};
+    return Run(blob, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> ORTDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    if (format == PixelFormat::BGR)
+        return Detect(frame);
+    if (isInited_ == false)
+        return {};
+
+    // --- Preprocessing
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    float scale;
+    int resize_rows, resize_cols, pad_rows, pad_cols;
+    GetLetterboxDimensions(
+        img_rows, img_cols, true,
+        resize_rows, resize_cols, pad_rows, pad_cols, scale
+    );
+    // fused letterbox straight from YUV
+    const int rows = resize_rows + pad_rows;
+    const int cols = resize_cols + pad_cols;
+    cv::Mat blob(std::vector<int>{1, 3, rows, cols}, CV_32F);
+    float *data = blob.ptr<float>();
+    LetterboxYUV(frame, format, resize_rows, resize_cols, pad_rows, pad_cols,
+        {data, data + rows * cols, data + 2 * rows * cols});
+
+    return Run(blob, img_rows, img_cols, pad_rows, pad_cols, scale);
+}
+
+std::vector<Object> ORTDetector::Run(cv::Mat &blob, const int img_rows, const int img_cols,
+    const int pad_rows, const int pad_cols, const float scale)
+{
+    std::vector<int64_t> input_tensor_shape = {1, 3, blob.size[2], blob.size[3]};
     int64_t data_element_count = 1;
     for (const auto &element : input_tensor_shape)
         data_element_count *= element;
@@ -48,7 +104,7 @@ std::vector<Object> ORTDetector::Detect(const cv::Mat &bgr)
     );
 
     // -- Model inference
-    std::vector<Ort::Value> output_tensors = session_.Run(
+    std::vector<Ort::Value> output_tensors = session_->Run(
         Ort::RunOptions{nullptr},
         input_names_ptr_.data(),
         &input_tensors,
@@ -58,23 +114,33 @@ std::vector<Object> ORTDetector::Detect(const cv::Mat &bgr)
     );
 
     // --- Postprocessing
-    std::vector<Object> proposals, objects;
-    for (size_t i = 0; i < strides_.size(); ++i)
+    std::vector<Object> objects;
+    if (has_nms_head_)
+    {
+        // decoding and NMS already ran inside the model
+        auto output_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
+        ParseDetections(
+            output_tensors[0].GetTensorData<float>(), static_cast<int>(output_shape[0]), objects,
+            img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale
+        );
+        return objects;
+    }
+    std::array<FeatureView, 3> heads;
+    for (size_t i = 0; i < heads.size(); ++i)
     {
-        std::vector<Object> temp;
         auto output_shape = output_tensors[i].GetTensorTypeAndShapeInfo().GetShape();
-        GenerateProposals(
+        heads[i] = {
             output_tensors[i].GetTensorData<float>(),
             {
                 static_cast<int>(output_shape[0]), static_cast<int>(output_shape[1]),
                 static_cast<int>(output_shape[2]), static_cast<int>(output_shape[3])
             },
-            strides_[i], anchors_[i], temp
-        );
-        proposals.insert(proposals.end(), temp.begin(), temp.end());
+            static_cast<size_t>(output_shape[2] * output_shape[3])
+        };
     }
+    GenerateProposals(heads, proposals_);
 
-    NMS(proposals, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
+    NMS(proposals_, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
 
     return objects;
 }
@@ -84,13 +150,22 @@ bool ORTDetector::Initialize(const int threads, const std::string &model_path,
     const int target_size, const int max_stride, const int num_class)
 {
     // create env, session, and memory
-    env_ = Ort::Env(OrtLoggingLevel::ORT_LOGGING_LEVEL_WARNING, "YOLOV5_ONNXRUNTIME");
+    env_ = GetProcessShared<Ort::Env>([]() {
+        return std::make_shared<Ort::Env>(OrtLoggingLevel::ORT_LOGGING_LEVEL_WARNING, "YOLOV5_ONNXRUNTIME");
+    });
+    // sessions of the same model reuse the weights repacked for the CPU kernels
+    prepacked_weights_ = GetProcessShared<Ort::PrepackedWeightsContainer>([]() {
+        return std::make_shared<Ort::PrepackedWeightsContainer>();
+    });
     Ort::SessionOptions session_options;
-    session_options.SetIntraOpNumThreads(std::max(1, threads));
+    threads_ = std::max(1, threads);
+    session_options.SetIntraOpNumThreads(threads_);
     session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
     try
     {
-        session_ = Ort::Session(env_, (model_path + ".onnx").c_str(), session_options);
+        session_ = std::make_shared<Ort::Session>(
+            *env_, (model_path + ".onnx").c_str(), session_options, *prepacked_weights_
+        );
     }
     catch (const Ort::Exception& e)
     {
@@ -104,15 +179,16 @@ bool ORTDetector::Initialize(const int threads, const std::string &model_path,
 
     // get input & output names for inference
     Ort::AllocatorWithDefaultOptions allocator;
-    auto in_count = session_.GetInputCount(), out_count = session_.GetOutputCount();
+    auto in_count = session_->GetInputCount(), out_count = session_->GetOutputCount();
     for (size_t i = 0; i < in_count; ++i)
-        input_names_.emplace_back(std::string(session_.GetInputNameAllocated(i, allocator).get()));
+        input_names_.emplace_back(std::string(session_->GetInputNameAllocated(i, allocator).get()));
     for (size_t i = 0; i < out_count; ++i)
-        output_names_.emplace_back(std::string(session_.GetOutputNameAllocated(i, allocator).get()));
+        output_names_.emplace_back(std::string(session_->GetOutputNameAllocated(i, allocator).get()));
     for (const auto &name : input_names_)
         input_names_ptr_.emplace_back(name.c_str());
     for (const auto &name : output_names_)
         output_names_ptr_.emplace_back(name.c_str());
+    has_nms_head_ = out_count == 1;
 
     conf_thres_ = conf_thres;
     nms_thres_ = nms_thres;
@@ -124,4 +200,27 @@ bool ORTDetector::Initialize(const int threads, const std::string &model_path,
     return true;
 }
 
-}   // namespace Infer
\ No newline at end of file
+std::unique_ptr<BaseDetector> ORTDetector::CreateSharedInstance()
+{
+    if (isInited_ == false)
+        return nullptr;
+
+    auto detector = std::make_unique<ORTDetector>();
+    detector->env_ = env_;
+    detector->prepacked_weights_ = prepacked_weights_;
+    detector->session_ = session_;
+    detector->memory_info_ = Ort::MemoryInfo::CreateCpu(
+        OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault
+    );
+    detector->input_names_ = input_names_;
+    detector->output_names_ = output_names_;
+    for (const auto &name : detector->input_names_)
+        detector->input_names_ptr_.emplace_back(name.c_str());
+    for (const auto &name : detector->output_names_)
+        detector->output_names_ptr_.emplace_back(name.c_str());
+    detector->has_nms_head_ = has_nms_head_;
+    detector->CopySettings(*this);
+    return detector;
+}
+
+}   // namespace Infer
@@ -3,7 +3,8 @@
 namespace Infer
 {
 
-OVDetector::OVDetector()
+OVDetector::OVDetector(const bool embed_preprocess)
+    : embed_preprocess_(embed_preprocess)
 {
 
 }
@@ -16,6 +17,8 @@ std::vector<Object> OVDetector::Detect(const cv::Mat &bgr)
 {
     if (isInited_ == false)
         return {};
+    if (embed_preprocess_)
+        return DetectEmbedded(bgr, PixelFormat::BGR);
 
     // --- Preprocessing
     // letterbox with size of target_size_ x target_size_
@@ -35,33 +38,91 @@ std::vector<Object> OVDetector::Detect(const cv::Mat &bgr)
         pad_cols / 2, pad_cols - pad_cols / 2,
         cv::BORDER_CONSTANT, cv::Scalar(114.0, 114.0, 114.0)
     );
+
+    return Run(letterbox, letterbox.rows, letterbox.cols, img_rows, img_cols,
+        pad_rows / 2, pad_cols / 2, scale, scale);
+}
+
+std::vector<Object> OVDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    if (format == PixelFormat::BGR)
+        return Detect(frame);
+    // NV12 is converted inside the compiled model, other formats are converted on the host
+    if (isInited_ && embed_preprocess_ && format == PixelFormat::NV12)
+        return DetectEmbedded(frame, format);
+    return BaseDetector::Detect(frame, format);
+}
+
+std::vector<Object> OVDetector::DetectEmbedded(const cv::Mat &frame, const PixelFormat format)
+{
+    // feed the raw frame, the compiled model resizes, converts and normalizes it
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    const EmbeddedKey key = {target_size_, img_rows, img_cols, static_cast<int>(format)};
+    if (key != embedded_key_)
+    {
+        auto it = embedded_models_.find(key);
+        if (it == embedded_models_.end())
+        {
+            EmbeddedModel embedded;
+            if (CompileEmbedded(img_rows, img_cols, format, embedded) == false)
+                return {};
+            it = embedded_models_.emplace(key, std::move(embedded)).first;
+        }
+        net_ = it->second.net;
+        compiled_model_ = it->second.compiled_model;
+        infer_request_ = it->second.infer_request;
+        input_size_ = it->second.input_size;
+        embedded_key_ = key;
+    }
+
+    return Run(frame.isContinuous() ? frame : frame.clone(), input_size_.height, input_size_.width,
+        img_rows, img_cols, 0.0f, 0.0f,
+        static_cast<float>(input_size_.height) / img_rows, static_cast<float>(input_size_.width) / img_cols);
+}
+
+std::vector<Object> OVDetector::Run(const cv::Mat &input, const int input_rows, const int input_cols,
+    const int img_rows, const int img_cols,
+    const float dh, const float dw, const float ratio_h, const float ratio_w)
+{
     // create input
     ov::Shape input_shape = {1,
-        static_cast<unsigned long>(letterbox.rows),
-        static_cast<unsigned long>(letterbox.cols),
-        static_cast<unsigned long>(letterbox.channels())
+        static_cast<unsigned long>(input.rows),
+        static_cast<unsigned long>(input.cols),
+        static_cast<unsigned long>(input.channels())
     };
-    ov::Tensor input_tensor = ov::Tensor(compiled_model_.input().get_element_type(), input_shape, letterbox.data);
+    ov::Tensor input_tensor = ov::Tensor(compiled_model_.input().get_element_type(), input_shape, input.data);
     infer_request_.set_input_tensor(input_tensor);
 
     // --- Model inference
     infer_request_.infer();
 
     // --- Postprocessing
-    std::vector<Object> proposals, objects;
-    for (size_t i = 0; i < net_->outputs().size(); ++i)
+    std::vector<Object> objects;
+    if (has_nms_head_)
+    {
+        // decoding and NMS already ran inside the model
+        const auto &output_tensor = infer_request_.get_output_tensor(0);
+        ParseDetections(
+            output_tensor.data<float>(), static_cast<int>(output_tensor.get_shape()[0]), objects,
+            img_rows, img_cols, dh, dw, ratio_h, ratio_w
+        );
+        return objects;
+    }
+    std::array<FeatureView, 3> heads;
+    for (size_t i = 0; i < heads.size(); ++i)
     {
+        // the tensor memory is owned by the infer request and stays valid until the next inference
         const auto &output_tensor = infer_request_.get_output_tensor(i);
-        std::vector<Object> temp;
-        GenerateProposals(
+        heads[i] = {
             output_tensor.data<float>(),
-            {1, letterbox.rows / strides_[i], letterbox.cols / strides_[i], (num_class_ + 5) * 3},
-            strides_[i], anchors_[i], temp
-        );
-        proposals.insert(proposals.end(), temp.begin(), temp.end());
+            {1, input_rows / strides_[i], input_cols / strides_[i], (num_class_ + 5) * 3},
+            static_cast<size_t>(input_cols / strides_[i]) * (num_class_ + 5) * 3
+        };
     }
+    GenerateProposals(heads, proposals_);
 
-    NMS(proposals, objects, img_rows, img_cols, pad_rows / 2, pad_cols / 2, scale, scale);
+    NMS(proposals_, objects, img_rows, img_cols, dh, dw, ratio_h, ratio_w);
 
     return objects;
 }
@@ -73,18 +134,35 @@ bool OVDetector::Initialize(const int threads, const std::string &model_path,
     // --- Load model
     try
     {
-        net_ = core_.read_model(model_path + ".xml", model_path + ".bin");
+        model_ = core_.read_model(model_path + ".xml", model_path + ".bin");
     }
     catch (const ov::Exception& e)
     {
         std::cout << "Failed to load model: " << e.what() << "\n";
         return false;
     }
+    threads_ = std::max(1, threads);
+    has_nms_head_ = model_->outputs().size() == 1;
+
+    conf_thres_ = conf_thres;
+    nms_thres_ = nms_thres;
+    target_size_ = target_size;
+    max_stride_ = max_stride;
+    num_class_ = num_class;
+
+    // the embedded preprocessing depends on the frame size, so compilation is deferred to the first frame
+    if (embed_preprocess_)
+    {
+        embedded_models_.clear();
+        embedded_key_ = {};
+        isInited_ = true;
+        return true;
+    }
 
     // --- Use PrePostProcessor API
     // instance PrePostProcessor object
-    ov::preprocess::PrePostProcessor ppp = ov::preprocess::PrePostProcessor(net_);
-    for (const auto &input : net_->inputs())
+    ov::preprocess::PrePostProcessor ppp = ov::preprocess::PrePostProcessor(model_->clone());
+    for (const auto &input : model_->inputs())
     {
         std::string input_name = input.get_any_name();
         // declare input data information (opencv style)
@@ -101,7 +179,7 @@ bool OVDetector::Initialize(const int threads, const std::string &model_path,
             .mean({0.0f, 0.0f, 0.0f})
             .scale({255.0f, 255.0f, 255.0f});
     }
-    for (const auto &output : net_->outputs())
+    for (const auto &output : model_->outputs())
     {
         std::string output_name = output.get_any_name();
         // set output tensor information
@@ -112,17 +190,120 @@ bool OVDetector::Initialize(const int threads, const std::string &model_path,
     if (net_ == nullptr)
         return false;
     // change CPU to GPU to enable GPU acceleration
-    compiled_model_ = core_.compile_model(net_, "CPU", ov::inference_num_threads(std::max(1, threads)));
+    compiled_model_ = core_.compile_model(net_, "CPU", ov::inference_num_threads(threads_));
     infer_request_ = compiled_model_.create_infer_request();
 
-    conf_thres_ = conf_thres;
-    nms_thres_ = nms_thres;
-    target_size_ = target_size;
-    max_stride_ = max_stride;
-    num_class_ = num_class;
-
     isInited_ = true;
     return true;
 }
 
-}   // namespace Infer
\ No newline at end of file
+std::unique_ptr<BaseDetector> OVDetector::CreateSharedInstance()
+{
+    if (isInited_ == false)
+        return nullptr;
+
+    auto detector = std::make_unique<OVDetector>(embed_preprocess_);
+    detector->model_ = model_;
+    detector->has_nms_head_ = has_nms_head_;
+    detector->CopySettings(*this);
+    if (embed_preprocess_)
+    {
+        // the compiled shapes are shared, each with a new infer request,
+        // shapes compiled later are compiled by each instance on its own
+        for (const auto &[key, embedded] : embedded_models_)
+        {
+            EmbeddedModel shared = {embedded.net, embedded.compiled_model,
+                embedded.compiled_model.create_infer_request(), embedded.input_size};
+            detector->embedded_models_.emplace(key, std::move(shared));
+        }
+    }
+    else if (net_ != nullptr)
+    {
+        detector->net_ = net_;
+        detector->compiled_model_ = compiled_model_;
+        detector->infer_request_ = compiled_model_.create_infer_request();
+    }
+    return detector;
+}
+
+bool OVDetector::SetTargetSize(const int target_size)
+{
+    if (target_size == target_size_)
+        return true;
+    // the embedded resize has a fixed destination, the model of the new size is selected or compiled
+    // on the next frame
+    return BaseDetector::SetTargetSize(target_size);
+}
+
+bool OVDetector::CompileEmbedded(const int img_rows, const int img_cols, const PixelFormat format,
+    EmbeddedModel &embedded)
+{
+    // the letterbox padding is replaced by stretching the frame to the stride-aligned input size,
+    // which distorts the aspect ratio by less than one stride and is undone with separate ratios in NMS
+    float scale;
+    int resize_rows, resize_cols, pad_rows, pad_cols;
+    GetLetterboxDimensions(
+        img_rows, img_cols, true,
+        resize_rows, resize_cols, pad_rows, pad_cols, scale
+    );
+    const int input_rows = resize_rows + pad_rows;
+    const int input_cols = resize_cols + pad_cols;
+
+    try
+    {
+        // fix the model input size so that the resize step knows its destination
+        std::shared_ptr<ov::Model> model = model_->clone();
+        model->reshape({1, 3, input_rows, input_cols});
+
+        ov::preprocess::PrePostProcessor ppp = ov::preprocess::PrePostProcessor(model);
+        for (const auto &input : model->inputs())
+        {
+            std::string input_name = input.get_any_name();
+            // declare input data information (raw camera frame)
+            if (format == PixelFormat::NV12)
+            {
+                ppp.input(input_name).tensor()
+                    .set_element_type(ov::element::u8)
+                    .set_layout("NHWC")
+                    .set_color_format(ov::preprocess::ColorFormat::NV12_SINGLE_PLANE)
+                    .set_shape({1, img_rows * 3 / 2, img_cols, 1});
+            }
+            else
+            {
+                ppp.input(input_name).tensor()
+                    .set_element_type(ov::element::u8)
+                    .set_layout("NHWC")
+                    .set_color_format(ov::preprocess::ColorFormat::BGR)
+                    .set_shape({1, img_rows, img_cols, 3});
+            }
+            // specify actual model layout (pytorch style)
+            ppp.input(input_name).model().set_layout("NCHW");
+            // convert, resize and normalize in one fused graph
+            ppp.input(input_name).preprocess()
+                .convert_color(ov::preprocess::ColorFormat::RGB)
+                .convert_element_type(ov::element::f32)
+                .resize(ov::preprocess::ResizeAlgorithm::RESIZE_LINEAR)
+                .mean({0.0f, 0.0f, 0.0f})
+                .scale({255.0f, 255.0f, 255.0f});
+        }
+        for (const auto &output : model->outputs())
+        {
+            std::string output_name = output.get_any_name();
+            // set output tensor information
+            ppp.output(output_name).tensor().set_element_type(ov::element::f32);
+        }
+        embedded.net = ppp.build();
+        embedded.compiled_model = core_.compile_model(embedded.net, "CPU", ov::inference_num_threads(threads_));
+        embedded.infer_request = embedded.compiled_model.create_infer_request();
+    }
+    catch (const ov::Exception &e)
+    {
+        std::cout << "Failed to compile model: " << e.what() << "\n";
+        return false;
+    }
+
+    embedded.input_size = cv::Size(input_cols, input_rows);
+    return true;
+}
+
+}   // namespace Infer
@@ -0,0 +1,178 @@
+#include "pipeline/config_loader.hpp"
+#include <filesystem>
+#include <algorithm>
+
+#include "detectors/ncnn_detector.hpp"
+#include "detectors/ov_detector.hpp"
+#include "detectors/mnn_detector.hpp"
+#include "detectors/ort_detector.hpp"
+#include "detectors/cv_detector.hpp"
+#include "pipeline/deadline_detector.hpp"
+
+namespace Infer
+{
+
+std::string GetModelPath(const nlohmann::json &config, const std::string &config_path)
+{
+    std::vector<std::string> support_frameworks = config.at("Inference").at("Supports").get<std::vector<std::string>>();
+    int framework = config.at("Inference").at("Framework").get<int>();
+    std::filesystem::path path(config_path);
+    return path.parent_path().string() + "/models/" +
+        support_frameworks.at(framework) + "/" +
+        config.at("YOLOv5").at("ModelName").get<std::string>();
+}
+
+bool GetPostprocessSettings(const nlohmann::json &config, PostprocessSettings &settings)
+{
+    const auto &yolo_config = config.at("YOLOv5");
+    settings.conf_thres = yolo_config.at("ConfThreshold").get<float>();
+    settings.nms_thres = yolo_config.at("NMSThreshold").get<float>();
+    settings.max_candidates = yolo_config.at("MaxCandidates").get<int>();
+    settings.max_detections = yolo_config.at("MaxDetections").get<int>();
+
+    // classes are given by label name
+    auto labels = yolo_config.at("Labels").get<std::vector<std::string>>();
+    settings.class_filter.clear();
+    for (const auto &name : yolo_config.at("ClassFilter").get<std::vector<std::string>>())
+    {
+        auto it = std::find(labels.begin(), labels.end(), name);
+        if (it == labels.end())
+        {
+            std::cout << "Unknown class in ClassFilter: " << name << "\n";
+            return false;
+        }
+        settings.class_filter.push_back(static_cast<int>(it - labels.begin()));
+    }
+    return true;
+}
+
+namespace
+{
+
+// ncnn reads a mapped model in place while running, a model file overwritten for a hot reload
+// would then crash the running detectors, so the model is read into memory when reloading is enabled
+bool UseMemoryMap(const nlohmann::json &config)
+{
+    bool memory_map = config.at("Inference").at("MemoryMap").get<bool>();
+    if (memory_map && config.at("HotReload").at("Enable").get<bool>())
+    {
+        std::cout << "MemoryMap is turned off since HotReload is enabled\n";
+        return false;
+    }
+    return memory_map;
+}
+
+std::unique_ptr<BaseDetector> CreateFrameworkDetector(const nlohmann::json &config, const std::string &model_path)
+{
+    // load framework
+    std::unique_ptr<BaseDetector> detector = nullptr;
+    int framework = config.at("Inference").at("Framework").get<int>();
+    switch (framework)
+    {
+        case 0:
+            detector = std::make_unique<NCNNDetector>(
+                UseMemoryMap(config)
+            );
+            break;
+        case 1:
+            detector = std::make_unique<OVDetector>(
+                config.at("Inference").at("EmbedPreprocess").get<bool>()
+            );
+            break;
+        case 2:
+            detector = std::make_unique<MNNDetector>(
+                config.at("Inference").at("MemoryMap").get<bool>()
+            );
+            break;
+        case 3:
+            detector = std::make_unique<ORTDetector>();
+            break;
+        case 4:
+            detector = std::make_unique<CVDetector>();
+            break;
+        default:
+            std::cout << "Unknown model: " << framework << "\n";
+            return nullptr;
+    }
+    if (detector->Initialize(
+        config.at("Inference").at("Threads").get<int>(),
+        model_path,
+        config.at("YOLOv5").at("ConfThreshold").get<float>(),
+        config.at("YOLOv5").at("NMSThreshold").get<float>(),
+        config.at("YOLOv5").at("TargetSize").get<int>(),
+        config.at("YOLOv5").at("MaxStride").get<int>(),
+        static_cast<int>(config.at("YOLOv5").at("Labels").size())
+    ) == false)
+        return nullptr;
+    detector->SetRawLogits(config.at("YOLOv5").at("RawLogits").get<bool>());
+    PostprocessSettings settings;
+    if (GetPostprocessSettings(config, settings) == false)
+        return nullptr;
+    detector->SetPostprocessSettings(settings);
+
+    return detector;
+}
+
+}   // namespace
+
+std::unique_ptr<BaseDetector> CreateDetector(const nlohmann::json &config, const std::string &model_path)
+{
+    std::unique_ptr<BaseDetector> detector = CreateFrameworkDetector(config, model_path);
+    const auto &deadline_config = config.at("Deadline");
+    if (detector == nullptr || deadline_config.at("Enable").get<bool>() == false)
+        return detector;
+
+    // the fallback model lives next to the primary one
+    std::unique_ptr<BaseDetector> fallback = nullptr;
+    std::string fallback_name = deadline_config.at("FallbackModel").get<std::string>();
+    if (fallback_name.empty() == false)
+    {
+        std::filesystem::path fallback_path(model_path);
+        fallback_path.replace_filename(fallback_name);
+        fallback = CreateFrameworkDetector(config, fallback_path.string());
+        if (fallback == nullptr)
+        {
+            std::cout << "Failed to load fallback model " << fallback_path.string() << "\n";
+            return nullptr;
+        }
+    }
+
+    auto deadline_detector = std::make_unique<DeadlineDetector>(std::move(detector), std::move(fallback));
+    deadline_detector->Configure(
+        deadline_config.at("BudgetMs").get<double>(),
+        deadline_config.at("RaisedConfThreshold").get<float>(),
+        deadline_config.at("ReducedTargetSize").get<int>(),
+        deadline_config.at("ProbeInterval").get<int>()
+    );
+    return deadline_detector;
+}
+
+std::vector<std::unique_ptr<BaseDetector>> CreateDetectors(const nlohmann::json &config, const std::string &model_path,
+    const int count)
+{
+    std::vector<std::unique_ptr<BaseDetector>> detectors;
+    std::unique_ptr<BaseDetector> detector = CreateDetector(config, model_path);
+    if (detector == nullptr)
+        return {};
+    for (int i = 1; i < count; ++i)
+    {
+        std::unique_ptr<BaseDetector> instance = detector->CreateSharedInstance();
+        if (instance == nullptr)
+            instance = CreateDetector(config, model_path);
+        if (instance == nullptr)
+            return {};
+        detectors.push_back(std::move(instance));
+    }
+    detectors.push_back(std::move(detector));
+    return detectors;
+}
+
+std::vector<cv::Point> ToPolygon(const nlohmann::json &points)
+{
+    std::vector<cv::Point> polygon;
+    for (const auto &point : points)
+        polygon.emplace_back(point.at(0).get<int>(), point.at(1).get<int>());
+    return polygon;
+}
+
+}   // namespace Infer
@@ -0,0 +1,144 @@
+#include "pipeline/config_watcher.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+
+#include "pipeline/config_loader.hpp"
+
+namespace Infer
+{
+
+ConfigWatcher::~ConfigWatcher()
+{
+    Stop();
+}
+
+bool ConfigWatcher::Start(const std::string &config_path, const nlohmann::json &config, const bool watch,
+    const int poll_ms, Callback on_change)
+{
+    Stop();
+    auto settings = std::make_shared<LiveSettings>();
+    if (Parse(config, *settings) == false)
+        return false;
+    std::atomic_store(&settings_, std::shared_ptr<const LiveSettings>(std::move(settings)));
+
+    config_path_ = config_path;
+    poll_ms_ = std::max(1, poll_ms);
+    on_change_ = std::move(on_change);
+    if (watch)
+    {
+        running_ = true;
+        thread_ = std::thread(&ConfigWatcher::Run, this);
+    }
+    return true;
+}
+
+void ConfigWatcher::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+std::shared_ptr<const LiveSettings> ConfigWatcher::Get() const
+{
+    return std::atomic_load(&settings_);
+}
+
+bool ConfigWatcher::Parse(const nlohmann::json &config, LiveSettings &settings)
+{
+    try
+    {
+        settings.labels = config.at("YOLOv5").at("Labels").get<std::vector<std::string>>();
+        return GetPostprocessSettings(config, settings.postprocess);
+    }
+    catch(const nlohmann::json::exception &e)
+    {
+        std::cout << e.what() << "\n";
+        return false;
+    }
+}
+
+void ConfigWatcher::Run()
+{
+    uint64_t current = GetFingerprint();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        cv_.wait_for(lock, std::chrono::milliseconds(poll_ms_), [this] { return !running_; });
+        if (!running_)
+            break;
+        lock.unlock();
+
+        // a half-written file fails to parse and is read again on the next change
+        uint64_t fingerprint = GetFingerprint();
+        if (fingerprint != current)
+        {
+            current = fingerprint;
+            Reload();
+        }
+
+        lock.lock();
+    }
+}
+
+void ConfigWatcher::Reload()
+{
+    nlohmann::json config;
+    try
+    {
+        std::ifstream config_file(config_path_);
+        config = nlohmann::json::parse(config_file, nullptr, true, true);
+    }
+    catch(const nlohmann::json::exception &e)
+    {
+        std::cout << "Failed to read JSON config at " << config_path_ << ", keeping the current settings\n";
+        return;
+    }
+
+    auto settings = std::make_shared<LiveSettings>();
+    std::shared_ptr<const LiveSettings> current = Get();
+    if (Parse(config, *settings) == false)
+    {
+        std::cout << "Invalid settings in " << config_path_ << ", keeping the current ones\n";
+        return;
+    }
+    // the classes are fixed by the model
+    if (settings->labels.size() != current->labels.size())
+    {
+        std::cout << "The number of labels cannot change at runtime, keeping the current settings\n";
+        return;
+    }
+
+    const PostprocessSettings &a = settings->postprocess;
+    const PostprocessSettings &b = current->postprocess;
+    if (a.conf_thres == b.conf_thres && a.nms_thres == b.nms_thres &&
+        a.max_candidates == b.max_candidates && a.max_detections == b.max_detections &&
+        a.class_filter == b.class_filter && settings->labels == current->labels)
+        return;
+
+    std::shared_ptr<const LiveSettings> published(std::move(settings));
+    std::atomic_store(&settings_, published);
+    std::cout << "Settings updated from " << config_path_ << "\n";
+    if (on_change_)
+        on_change_(published);
+}
+
+uint64_t ConfigWatcher::GetFingerprint() const
+{
+    std::error_code ec;
+    uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(config_path_, ec));
+    if (ec)
+        return 0;
+    uint64_t time = static_cast<uint64_t>(std::filesystem::last_write_time(config_path_, ec).time_since_epoch().count());
+    return size * 1099511628211ull ^ time;
+}
+
+}   // namespace Infer
@@ -0,0 +1,187 @@
+#include "pipeline/deadline_detector.hpp"
+#include <chrono>
+#include <algorithm>
+
+namespace Infer
+{
+
+const char * GetDegradeLevelName(const DegradeLevel level)
+{
+    switch (level)
+    {
+        case DegradeLevel::Full:
+            return "Full";
+        case DegradeLevel::RaisedThreshold:
+            return "RaisedThreshold";
+        case DegradeLevel::ReducedSize:
+            return "ReducedSize";
+        case DegradeLevel::FallbackModel:
+            return "FallbackModel";
+    }
+    return "Unknown";
+}
+
+DeadlineDetector::DeadlineDetector(std::unique_ptr<BaseDetector> primary, std::unique_ptr<BaseDetector> fallback)
+    : primary_(std::move(primary)), fallback_(std::move(fallback))
+{
+    // the settings of this detector are the full quality settings of the primary detector
+    CopySettings(*primary_);
+    if (fallback_ != nullptr)
+    {
+        fallback_conf_thres_ = fallback_->GetConfThreshold();
+        fallback_target_size_ = fallback_->GetTargetSize();
+    }
+    raised_conf_thres_ = conf_thres_;
+    reduced_target_size_ = target_size_;
+}
+
+void DeadlineDetector::Configure(const double budget_ms, const float raised_conf_thres,
+    const int reduced_target_size, const int probe_interval)
+{
+    budget_ms_ = budget_ms;
+    raised_conf_thres_ = raised_conf_thres;
+    reduced_target_size_ = reduced_target_size;
+    probe_interval_ = std::max(1, probe_interval);
+    estimates_ms_.fill(0.0);
+}
+
+std::vector<Object> DeadlineDetector::Detect(const cv::Mat &bgr)
+{
+    return Detect(bgr, PixelFormat::BGR);
+}
+
+std::vector<Object> DeadlineDetector::Detect(const cv::Mat &frame, const PixelFormat format)
+{
+    DegradeLevel level;
+    return Detect(frame, format, budget_ms_, level);
+}
+
+std::vector<Object> DeadlineDetector::Detect(const cv::Mat &frame, const PixelFormat format,
+    const double budget_ms, DegradeLevel &level)
+{
+    if (isInited_ == false)
+        return {};
+
+    level = budget_ms > 0.0 ? SelectLevel(budget_ms) : DegradeLevel::Full;
+    const int index = static_cast<int>(level);
+
+    // each level includes the degradations of the previous ones
+    BaseDetector &detector = level == DegradeLevel::FallbackModel ? *fallback_ : *primary_;
+    const float conf_thres = level == DegradeLevel::FallbackModel ? fallback_conf_thres_ : conf_thres_;
+    const int target_size = level == DegradeLevel::FallbackModel ? fallback_target_size_ : target_size_;
+    detector.SetConfThreshold(level >= DegradeLevel::RaisedThreshold ?
+        std::max(conf_thres, raised_conf_thres_) : conf_thres);
+    if (level < DegradeLevel::ReducedSize || detector.SetTargetSize(reduced_target_size_) == false)
+        detector.SetTargetSize(target_size);
+
+    // the first run of a shape includes one-time setup such as compiling or resizing sessions
+    int img_rows, img_cols;
+    GetImageSize(frame, format, img_rows, img_cols);
+    const bool first_run = seen_shapes_.insert(
+        {index, detector.GetTargetSize(), img_rows, img_cols, static_cast<int>(format)}).second;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Object> objects = detector.Detect(frame, format);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    // smoothed so that one slow frame degrades quickly but noise does not flip levels,
+    // setup time is left out so that it does not push the level further down
+    double &estimate = estimates_ms_[index];
+    if (first_run == false)
+        estimate = estimate == 0.0 ? elapsed.count() : 0.7 * estimate + 0.3 * elapsed.count();
+
+    last_level_ = level;
+    last_latency_ms_ = elapsed.count();
+    return objects;
+}
+
+DegradeLevel DeadlineDetector::SelectLevel(const double budget_ms)
+{
+    const int num_levels = fallback_ != nullptr ? kNumLevels : kNumLevels - 1;
+    const int current = static_cast<int>(last_level_);
+
+    // estimates of better levels were measured under earlier load, retry one of them from time to time
+    if (current > 0 && ++frames_degraded_ >= probe_interval_)
+    {
+        estimates_ms_[current - 1] = 0.0;
+        frames_degraded_ = 0;
+    }
+
+    // keep a margin since the estimate is an average
+    for (int level = 0; level < num_levels; ++level)
+    {
+        if (estimates_ms_[level] == 0.0 || estimates_ms_[level] <= budget_ms * 0.9)
+        {
+            if (level == 0)
+                frames_degraded_ = 0;
+            return static_cast<DegradeLevel>(level);
+        }
+    }
+    return static_cast<DegradeLevel>(num_levels - 1);
+}
+
+bool DeadlineDetector::Initialize(const int threads, const std::string &model_path,
+    const float conf_thres, const float nms_thres,
+    const int target_size, const int max_stride, const int num_class)
+{
+    if (primary_->Initialize(threads, model_path, conf_thres, nms_thres,
+        target_size, max_stride, num_class) == false)
+        return false;
+    CopySettings(*primary_);
+    estimates_ms_.fill(0.0);
+    return true;
+}
+
+std::unique_ptr<BaseDetector> DeadlineDetector::CreateSharedInstance()
+{
+    if (isInited_ == false)
+        return nullptr;
+
+    std::unique_ptr<BaseDetector> primary = primary_->CreateSharedInstance();
+    if (primary == nullptr)
+        return nullptr;
+    std::unique_ptr<BaseDetector> fallback = nullptr;
+    if (fallback_ != nullptr)
+    {
+        fallback = fallback_->CreateSharedInstance();
+        if (fallback == nullptr)
+            return nullptr;
+    }
+
+    auto detector = std::make_unique<DeadlineDetector>(std::move(primary), std::move(fallback));
+    detector->CopySettings(*this);
+    detector->fallback_conf_thres_ = fallback_conf_thres_;
+    detector->fallback_target_size_ = fallback_target_size_;
+    detector->Configure(budget_ms_, raised_conf_thres_, reduced_target_size_, probe_interval_);
+    return detector;
+}
+
+bool DeadlineDetector::SetTargetSize(const int target_size)
+{
+    if (primary_->SetTargetSize(target_size) == false)
+        return false;
+    return BaseDetector::SetTargetSize(target_size);
+}
+
+void DeadlineDetector::SetPostprocessSettings(const PostprocessSettings &settings)
+{
+    BaseDetector::SetPostprocessSettings(settings);
+    primary_->SetPostprocessSettings(settings);
+    if (fallback_ != nullptr)
+    {
+        fallback_->SetPostprocessSettings(settings);
+        fallback_conf_thres_ = settings.conf_thres;
+    }
+}
+
+DegradeLevel DeadlineDetector::GetLastLevel() const
+{
+    return last_level_;
+}
+
+double DeadlineDetector::GetLastLatency() const
+{
+    return last_latency_ms_;
+}
+
+}   // namespace Infer
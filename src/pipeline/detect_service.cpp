@@ -0,0 +1,134 @@
+#include "pipeline/detect_service.hpp"
+#include <algorithm>
+
+namespace Infer
+{
+
+DetectService::DetectService(DetectorPool &pool, const size_t max_queue, const int max_batch)
+    : pool_(pool), max_queue_(std::max<size_t>(1, max_queue)), max_batch_(std::max(1, max_batch))
+{
+
+}
+
+DetectService::~DetectService()
+{
+    Stop();
+}
+
+void DetectService::Start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_)
+            return;
+        running_ = true;
+    }
+
+    for (size_t i = 0; i < pool_.Size(); ++i)
+        workers_.emplace_back(&DetectService::WorkerLoop, this);
+}
+
+void DetectService::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    for (auto &worker : workers_)
+        worker.join();
+    workers_.clear();
+
+    // fail jobs that were never taken
+    for (auto &pending : queue_)
+        pending.promise.set_value(DetectResult());
+    queue_.clear();
+}
+
+bool DetectService::Submit(DetectJob job, std::future<DetectResult> &result)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ == false || queue_.size() >= max_queue_)
+        {
+            ++rejected_;
+            return false;
+        }
+        queue_.emplace_back();
+        PendingJob &pending = queue_.back();
+        pending.job = std::move(job);
+        pending.queued = std::chrono::steady_clock::now();
+        result = pending.promise.get_future();
+    }
+    cv_.notify_one();
+    return true;
+}
+
+size_t DetectService::GetQueueSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+uint64_t DetectService::GetRejectedCount() const
+{
+    return rejected_;
+}
+
+void DetectService::WorkerLoop()
+{
+    std::vector<PendingJob> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++idle_;
+            cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            --idle_;
+            if (running_ == false)
+                return;
+
+            // the detectors have no batch dimension, so jobs are spread over idle workers first,
+            // only a backlog that no idle worker can take is batched
+            size_t count = idle_ == 0 ? std::min(max_batch_, queue_.size()) : 1;
+            for (size_t i = 0; i < count; ++i)
+            {
+                batch.emplace_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        DetectorPool::Lease detector = pool_.Acquire();
+        for (auto &pending : batch)
+        {
+            DetectResult result;
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double, std::milli> queued = start - pending.queued;
+            result.queue_ms = queued.count();
+
+            cv::Mat frame = pending.job.frame;
+            PixelFormat format = pending.job.format;
+            if (pending.job.encoded.empty() == false)
+            {
+                cv::Mat encoded(1, static_cast<int>(pending.job.encoded.size()), CV_8UC1, pending.job.encoded.data());
+                frame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+                format = PixelFormat::BGR;
+            }
+
+            if (frame.empty() == false)
+            {
+                result.ok = true;
+                result.objects = detector->Detect(frame, format);
+                result.img_rows = format == PixelFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
+                result.img_cols = frame.cols;
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            result.elapsed_ms = elapsed.count();
+            pending.promise.set_value(std::move(result));
+        }
+        batch.clear();
+    }
+}
+
+}   // namespace Infer
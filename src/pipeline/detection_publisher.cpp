@@ -0,0 +1,192 @@
+#include "pipeline/detection_publisher.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Infer
+{
+
+namespace
+{
+
+// the wire format is little-endian, which is the byte order of every supported target
+template <typename T>
+void Append(std::string &buffer, const T value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+}   // namespace
+
+void EncodeDetections(const uint64_t frame_id, const int64_t timestamp_us,
+    const std::vector<Object> &objects, std::string &buffer)
+{
+    uint32_t length = static_cast<uint32_t>(kDetectionRecordHeader - 4 + objects.size() * kDetectionObjectSize);
+    buffer.reserve(buffer.size() + 4 + length);
+    Append(buffer, length);
+    Append(buffer, frame_id);
+    Append(buffer, timestamp_us);
+    Append(buffer, static_cast<uint32_t>(objects.size()));
+    for (const auto &obj : objects)
+    {
+        Append(buffer, static_cast<int32_t>(obj.label));
+        Append(buffer, obj.prob);
+        Append(buffer, obj.rect.x);
+        Append(buffer, obj.rect.y);
+        Append(buffer, obj.rect.width);
+        Append(buffer, obj.rect.height);
+    }
+}
+
+DetectionPublisher::~DetectionPublisher()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool DetectionPublisher::Open(const std::string &path, const size_t)
+{
+    std::cout << "Unix domain sockets are not supported on this platform, not publishing to " << path << "\n";
+    return false;
+}
+
+void DetectionPublisher::Close() {}
+void DetectionPublisher::Publish(const uint64_t, const int64_t, const std::vector<Object> &) {}
+size_t DetectionPublisher::GetClientCount() const { return 0; }
+uint64_t DetectionPublisher::GetDroppedCount() const { return 0; }
+
+#else
+
+bool DetectionPublisher::Open(const std::string &path, const size_t max_pending_bytes)
+{
+    Close();
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        std::cout << "Socket path is too long: " << path << "\n";
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+        return false;
+    // a socket file left behind by a crashed run would make bind fail
+    unlink(path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 16) != 0)
+    {
+        std::cout << "Failed to listen on " << path << ": " << std::strerror(errno) << "\n";
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    fcntl(listen_fd_, F_SETFL, fcntl(listen_fd_, F_GETFL) | O_NONBLOCK);
+
+    path_ = path;
+    max_pending_bytes_ = max_pending_bytes;
+    return true;
+}
+
+void DetectionPublisher::Close()
+{
+    for (auto &client : clients_)
+        close(client.fd);
+    clients_.clear();
+    if (listen_fd_ >= 0)
+    {
+        close(listen_fd_);
+        unlink(path_.c_str());
+        listen_fd_ = -1;
+    }
+}
+
+void DetectionPublisher::Publish(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects)
+{
+    if (listen_fd_ < 0)
+        return;
+    Accept();
+    if (clients_.empty())
+        return;
+
+    record_.clear();
+    EncodeDetections(frame_id, timestamp_us, objects, record_);
+
+    for (auto it = clients_.begin(); it != clients_.end();)
+    {
+        // whole records only, so that the stream stays parseable after drops
+        if (it->pending.size() + record_.size() <= max_pending_bytes_)
+            it->pending += record_;
+        else
+            ++dropped_;
+
+        if (Flush(*it))
+            ++it;
+        else
+        {
+            close(it->fd);
+            it = clients_.erase(it);
+        }
+    }
+}
+
+size_t DetectionPublisher::GetClientCount() const
+{
+    return clients_.size();
+}
+
+uint64_t DetectionPublisher::GetDroppedCount() const
+{
+    return dropped_;
+}
+
+void DetectionPublisher::Accept()
+{
+    int fd;
+    while ((fd = accept(listen_fd_, nullptr, nullptr)) >= 0)
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int nosigpipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+        clients_.push_back({fd, std::string()});
+    }
+}
+
+bool DetectionPublisher::Flush(Client &client)
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t sent = 0;
+    while (sent < client.pending.size())
+    {
+        ssize_t n = send(client.fd, client.pending.data() + sent, client.pending.size() - sent, flags);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    client.pending.erase(0, sent);
+    return true;
+}
+
+#endif  // _WIN32
+
+}   // namespace Infer
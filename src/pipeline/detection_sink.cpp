@@ -0,0 +1,129 @@
+#include "pipeline/detection_sink.hpp"
+#include <iostream>
+#include <cinttypes>
+
+#include "json.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Infer
+{
+
+namespace
+{
+
+// hand the standard output to the caller and point file descriptor 1 at standard error,
+// so that later diagnostics, including those printed by the backends, stay out of the results
+std::FILE * TakeStdout()
+{
+    std::cout.flush();
+    std::fflush(stdout);
+#ifdef _WIN32
+    int fd = _dup(_fileno(stdout));
+    if (fd < 0 || _dup2(_fileno(stderr), _fileno(stdout)) != 0)
+        return nullptr;
+    return _fdopen(fd, "w");
+#else
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+        return nullptr;
+    return fdopen(fd, "w");
+#endif
+}
+
+}   // namespace
+
+JsonLinesSink::JsonLinesSink(std::FILE *file, const bool owned, const bool flush, const std::vector<std::string> &labels)
+    : file_(file), owned_(owned), flush_(flush)
+{
+    SetLabels(labels);
+}
+
+JsonLinesSink::~JsonLinesSink()
+{
+    if (owned_)
+        std::fclose(file_);
+    else
+        std::fflush(file_);
+}
+
+void JsonLinesSink::Write(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects)
+{
+    std::fprintf(file_, "{\"frame\":%" PRIu64 ",\"timestamp_us\":%" PRId64 ",\"objects\":[", frame_id, timestamp_us);
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        const Object &obj = objects[i];
+        std::fprintf(file_, "%s{\"label\":%d,", i == 0 ? "" : ",", obj.label);
+        if (obj.label < static_cast<int>(labels_.size()))
+            std::fprintf(file_, "\"name\":%s,", labels_[obj.label].c_str());
+        std::fprintf(file_, "\"prob\":%.4f,\"box\":[%.1f,%.1f,%.1f,%.1f]}",
+            obj.prob, obj.rect.x, obj.rect.y, obj.rect.width, obj.rect.height);
+    }
+    std::fputs("]}\n", file_);
+    if (flush_)
+        std::fflush(file_);
+}
+
+void JsonLinesSink::SetLabels(const std::vector<std::string> &labels)
+{
+    // escaped once instead of per object
+    labels_.clear();
+    for (const auto &label : labels)
+        labels_.push_back(nlohmann::json(label).dump());
+}
+
+bool ResultLogSink::Open(const std::string &path)
+{
+    return writer_.Open(path);
+}
+
+void ResultLogSink::Write(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects)
+{
+    writer_.Append(frame_id, timestamp_us, objects);
+}
+
+bool CreateDetectionSink(const std::string &type, const std::string &path,
+    const std::vector<std::string> &labels, std::unique_ptr<DetectionSink> &sink)
+{
+    sink.reset();
+    if (type == "none")
+        return true;
+    if (type == "stdout")
+    {
+        std::FILE *file = TakeStdout();
+        if (file == nullptr)
+        {
+            std::cout << "Failed to redirect standard output\n";
+            return false;
+        }
+        sink = std::make_unique<JsonLinesSink>(file, true, true, labels);
+        return true;
+    }
+    if (type == "jsonl")
+    {
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+        {
+            std::cout << "Failed to open " << path << "\n";
+            return false;
+        }
+        sink = std::make_unique<JsonLinesSink>(file, true, false, labels);
+        return true;
+    }
+    if (type == "log")
+    {
+        auto log_sink = std::make_unique<ResultLogSink>();
+        if (log_sink->Open(path) == false)
+            return false;
+        sink = std::move(log_sink);
+        return true;
+    }
+    std::cout << "Unknown sink type: " << type << "\n";
+    return false;
+}
+
+}   // namespace Infer
@@ -0,0 +1,119 @@
+#include "pipeline/detector_pool.hpp"
+
+namespace Infer
+{
+
+DetectorPool::Lease::Lease(DetectorPool *pool, BaseDetector *detector, const uint64_t generation)
+    : pool_(pool), detector_(detector), generation_(generation)
+{
+
+}
+
+DetectorPool::Lease::~Lease()
+{
+    if (pool_ != nullptr)
+        pool_->Release(detector_, generation_);
+}
+
+DetectorPool::Lease::Lease(Lease &&other) noexcept
+    : pool_(other.pool_), detector_(other.detector_), generation_(other.generation_)
+{
+    other.pool_ = nullptr;
+    other.detector_ = nullptr;
+}
+
+BaseDetector & DetectorPool::Lease::operator*() const
+{
+    return *detector_;
+}
+
+BaseDetector * DetectorPool::Lease::operator->() const
+{
+    return detector_;
+}
+
+void DetectorPool::Add(std::unique_ptr<BaseDetector> detector)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ApplyUpdate(detector.get());
+    free_.push_back(detector.get());
+    detectors_.push_back(std::move(detector));
+    cv_.notify_one();
+}
+
+size_t DetectorPool::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detectors_.size();
+}
+
+DetectorPool::Lease DetectorPool::Acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !free_.empty(); });
+    BaseDetector *detector = free_.back();
+    free_.pop_back();
+    return Lease(this, detector, generation_);
+}
+
+void DetectorPool::Replace(std::vector<std::unique_ptr<BaseDetector>> detectors)
+{
+    std::vector<std::unique_ptr<BaseDetector>> retired;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        retired_leases_ += detectors_.size() - free_.size();
+        retired.swap(detectors_);
+        free_.clear();
+        for (const auto &detector : retired)
+            applied_.erase(detector.get());
+        for (auto &detector : detectors)
+        {
+            ApplyUpdate(detector.get());
+            free_.push_back(detector.get());
+            detectors_.push_back(std::move(detector));
+        }
+        ++generation_;
+        cv_.notify_all();
+
+        // in-flight detections finish on the old detectors
+        cv_.wait(lock, [this] { return retired_leases_ == 0; });
+    }
+    // old detectors are destroyed outside the lock
+}
+
+void DetectorPool::Update(std::function<void(BaseDetector &)> update)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_ = std::move(update);
+    ++update_version_;
+    for (BaseDetector *detector : free_)
+        ApplyUpdate(detector);
+}
+
+void DetectorPool::Release(BaseDetector *detector, const uint64_t generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation == generation_)
+        {
+            ApplyUpdate(detector);
+            free_.push_back(detector);
+        }
+        else
+            --retired_leases_;
+    }
+    // Replace may be waiting for retired leases, so wake all
+    cv_.notify_all();
+}
+
+void DetectorPool::ApplyUpdate(BaseDetector *detector)
+{
+    uint64_t &applied = applied_[detector];
+    if (update_ && applied != update_version_)
+    {
+        update_(*detector);
+        applied = update_version_;
+    }
+}
+
+}   // namespace Infer
@@ -0,0 +1,347 @@
+#include "pipeline/http_server.hpp"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Infer
+{
+
+namespace
+{
+
+constexpr size_t kMaxHeaderSize = 16 * 1024;
+constexpr int kIdleTimeoutSeconds = 30;
+// closed peers must not raise SIGPIPE, macOS uses SO_NOSIGPIPE instead
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+std::string ToLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string Trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+const char * GetReason(const int status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+void ParseQuery(const std::string &query, std::map<std::string, std::string> &params)
+{
+    std::stringstream ss(query);
+    std::string pair;
+    while (std::getline(ss, pair, '&'))
+    {
+        size_t eq = pair.find('=');
+        if (eq == std::string::npos)
+            params[pair] = "";
+        else
+            params[pair.substr(0, eq)] = pair.substr(eq + 1);
+    }
+}
+
+}   // namespace
+
+HttpServer::~HttpServer()
+{
+    Stop();
+}
+
+bool HttpServer::Start(const std::string &host, const int port, const int max_connections,
+    const size_t max_body_size, Handler handler)
+{
+    if (running_)
+        return false;
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+    {
+        std::cout << "Invalid host: " << host << "\n";
+        return false;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+        return false;
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 128) != 0)
+    {
+        std::cout << "Failed to listen on " << host << ":" << port << ": " << std::strerror(errno) << "\n";
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    max_connections_ = std::max(1, max_connections);
+    max_body_size_ = max_body_size;
+    handler_ = std::move(handler);
+    running_ = true;
+    accept_thread_ = std::thread(&HttpServer::AcceptLoop, this);
+    return true;
+}
+
+void HttpServer::Stop()
+{
+    if (running_.exchange(false) == false)
+        return;
+
+    accept_thread_.join();
+    close(listen_fd_);
+    listen_fd_ = -1;
+
+    // wake connection threads blocked in recv
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &connection : connections_)
+        {
+            if (connection.done == false)
+                shutdown(connection.fd, SHUT_RDWR);
+        }
+    }
+    for (auto &connection : connections_)
+        connection.thread.join();
+    connections_.clear();
+}
+
+void HttpServer::AcceptLoop()
+{
+    pollfd pfd = {listen_fd_, POLLIN, 0};
+    while (running_)
+    {
+        // poll with a timeout so that Stop does not depend on a new connection
+        if (poll(&pfd, 1, 200) <= 0)
+            continue;
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+#ifdef SO_NOSIGPIPE
+        int nosigpipe = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+        timeval timeout = {kIdleTimeoutSeconds, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // join finished connections
+        for (auto it = connections_.begin(); it != connections_.end();)
+        {
+            if (it->done)
+            {
+                it->thread.join();
+                it = connections_.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        if (static_cast<int>(connections_.size()) >= max_connections_)
+        {
+            HttpResponse response;
+            response.status = 503;
+            response.headers.emplace_back("Retry-After", "1");
+            response.body = "{\"error\":\"too many connections\"}";
+            SendResponse(fd, response, false);
+            close(fd);
+            continue;
+        }
+
+        connections_.emplace_back();
+        Connection &connection = connections_.back();
+        connection.fd = fd;
+        connection.thread = std::thread(&HttpServer::ServeConnection, this, std::ref(connection));
+    }
+}
+
+void HttpServer::ServeConnection(Connection &connection)
+{
+    std::string buffer;
+    while (running_)
+    {
+        HttpRequest request;
+        int status = 0;
+        if (ReadRequest(connection.fd, buffer, request, status) == false)
+        {
+            if (status != 0)
+            {
+                HttpResponse response;
+                response.status = status;
+                response.body = std::string("{\"error\":\"") + GetReason(status) + "\"}";
+                SendResponse(connection.fd, response, false);
+            }
+            break;
+        }
+
+        // HTTP/1.1 keeps the connection alive unless the client asks to close it, HTTP/1.0 the opposite
+        auto it = request.headers.find("connection");
+        std::string connection_field = it == request.headers.end() ? "" : ToLower(it->second);
+        bool keep_alive = request.version == "HTTP/1.0" ?
+            connection_field == "keep-alive" : connection_field != "close";
+
+        HttpResponse response;
+        try
+        {
+            handler_(request, response);
+        }
+        catch (const std::exception &e)
+        {
+            response = HttpResponse();
+            response.status = 500;
+            response.body = std::string("{\"error\":\"") + GetReason(500) + "\"}";
+        }
+        if (SendResponse(connection.fd, response, keep_alive) == false || keep_alive == false)
+            break;
+    }
+
+    // under the lock so that Stop never shuts down a reused descriptor
+    std::lock_guard<std::mutex> lock(mutex_);
+    close(connection.fd);
+    connection.done = true;
+}
+
+bool HttpServer::ReadRequest(const int fd, std::string &buffer, HttpRequest &request, int &status)
+{
+    status = 0;
+    char chunk[64 * 1024];
+
+    // headers
+    size_t header_end;
+    while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (buffer.size() > kMaxHeaderSize)
+        {
+            status = 431;
+            return false;
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, n);
+    }
+
+    std::stringstream ss(buffer.substr(0, header_end));
+    std::string line, target;
+    std::getline(ss, line);
+    std::stringstream request_line(line);
+    if (!(request_line >> request.method >> target >> request.version) || request.version.rfind("HTTP/1.", 0) != 0)
+    {
+        status = 400;
+        return false;
+    }
+    size_t question = target.find('?');
+    request.path = target.substr(0, question);
+    if (question != std::string::npos)
+        ParseQuery(target.substr(question + 1), request.query);
+    while (std::getline(ss, line))
+    {
+        size_t colon = line.find(':');
+        if (colon != std::string::npos)
+            request.headers[ToLower(Trim(line.substr(0, colon)))] = Trim(line.substr(colon + 1));
+    }
+    buffer.erase(0, header_end + 4);
+
+    if (request.headers.count("transfer-encoding"))
+    {
+        status = 501;
+        return false;
+    }
+
+    // body
+    size_t content_length = 0;
+    auto it = request.headers.find("content-length");
+    if (it != request.headers.end())
+    {
+        try
+        {
+            content_length = std::stoull(it->second);
+        }
+        catch (const std::exception &e)
+        {
+            status = 400;
+            return false;
+        }
+    }
+    if (content_length > max_body_size_)
+    {
+        status = 413;
+        return false;
+    }
+
+    request.body = buffer.substr(0, content_length);
+    buffer.erase(0, request.body.size());
+    while (request.body.size() < content_length)
+    {
+        ssize_t n = recv(fd, chunk, std::min(sizeof(chunk), content_length - request.body.size()), 0);
+        if (n <= 0)
+            return false;
+        request.body.append(chunk, n);
+    }
+    return true;
+}
+
+bool HttpServer::SendResponse(const int fd, const HttpResponse &response, const bool keep_alive)
+{
+    std::string header = "HTTP/1.1 " + std::to_string(response.status) + " " + GetReason(response.status) + "\r\n";
+    header += "Content-Type: " + response.content_type + "\r\n";
+    header += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    header += keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    for (const auto &field : response.headers)
+        header += field.first + ": " + field.second + "\r\n";
+    header += "\r\n";
+
+    for (const std::string *part : {static_cast<const std::string *>(&header), &response.body})
+    {
+        size_t sent = 0;
+        while (sent < part->size())
+        {
+            ssize_t n = send(fd, part->data() + sent, part->size() - sent, kSendFlags);
+            if (n <= 0)
+                return false;
+            sent += n;
+        }
+    }
+    return true;
+}
+
+}   // namespace Infer
@@ -0,0 +1,135 @@
+#include "pipeline/model_reloader.hpp"
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <algorithm>
+
+namespace Infer
+{
+
+ModelReloader::~ModelReloader()
+{
+    Stop();
+}
+
+void ModelReloader::Start(const std::string &model_path, const bool watch_files, const int poll_ms,
+    Factory factory, Warmup warmup, Install install)
+{
+    Stop();
+    model_path_ = model_path;
+    watch_files_ = watch_files;
+    poll_ms_ = std::max(1, poll_ms);
+    factory_ = std::move(factory);
+    warmup_ = std::move(warmup);
+    install_ = std::move(install);
+    reload_requested_ = false;
+    running_ = true;
+    thread_ = std::thread(&ModelReloader::Run, this);
+}
+
+void ModelReloader::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void ModelReloader::RequestReload()
+{
+    reload_requested_ = true;
+}
+
+int ModelReloader::GetReloadCount() const
+{
+    return reload_count_;
+}
+
+void ModelReloader::Run()
+{
+    uint64_t current = watch_files_ ? GetFingerprint() : 0;
+    uint64_t changed = current;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        cv_.wait_for(lock, std::chrono::milliseconds(poll_ms_), [this] { return !running_; });
+        if (!running_)
+            break;
+        lock.unlock();
+
+        bool reload = reload_requested_.exchange(false);
+        if (watch_files_)
+        {
+            // reload once the files stay unchanged for a poll, a copy may still be in progress
+            uint64_t fingerprint = GetFingerprint();
+            if (fingerprint != current && fingerprint == changed)
+                reload = true;
+            changed = fingerprint;
+        }
+        if (reload)
+        {
+            // a failed load is not retried until the files change again
+            Reload();
+            current = changed = watch_files_ ? GetFingerprint() : 0;
+        }
+
+        lock.lock();
+    }
+}
+
+bool ModelReloader::Reload()
+{
+    std::cout << "Reloading model " << model_path_ << "\n";
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<BaseDetector>> detectors = factory_();
+    if (detectors.empty())
+    {
+        std::cout << "Failed to reload model, keeping the current one\n";
+        return false;
+    }
+
+    // the first inference of some frameworks is much slower, and shape-dependent plans are built for the
+    // first input size, so each detector runs once on the input the caller feeds instead of the first frame
+    for (auto &detector : detectors)
+        warmup_(*detector);
+
+    install_(std::move(detectors));
+    ++reload_count_;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Model reloaded in " << elapsed.count() << " ms\n";
+    return true;
+}
+
+uint64_t ModelReloader::GetFingerprint() const
+{
+    namespace fs = std::filesystem;
+    fs::path model(model_path_);
+    fs::path directory = model.has_parent_path() ? model.parent_path() : fs::path(".");
+    std::string stem = model.filename().string();
+
+    // order independent, directory iteration order is unspecified
+    uint64_t fingerprint = 0;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(directory, ec))
+    {
+        std::string name = entry.path().filename().string();
+        // <model>.<ext> and <model>_<suffix>.<ext>, e.g. fixed-size buckets
+        if (name.size() <= stem.size() || name.compare(0, stem.size(), stem) != 0 ||
+            (name[stem.size()] != '.' && name[stem.size()] != '_'))
+            continue;
+        if (entry.is_regular_file(ec) == false)
+            continue;
+
+        uint64_t hash = std::hash<std::string>()(name);
+        hash = hash * 1099511628211ull ^ static_cast<uint64_t>(entry.file_size(ec));
+        hash = hash * 1099511628211ull ^ static_cast<uint64_t>(entry.last_write_time(ec).time_since_epoch().count());
+        fingerprint += hash;
+    }
+    return fingerprint;
+}
+
+}   // namespace Infer
@@ -0,0 +1,72 @@
+#include "pipeline/motion_gate.hpp"
+
+namespace Infer
+{
+
+void MotionGate::Configure(bool enable, int width, int pixel_thres, float min_changed_ratio, int max_skip_frames)
+{
+    enable_ = enable;
+    width_ = std::max(8, width);
+    pixel_thres_ = pixel_thres;
+    min_changed_ratio_ = min_changed_ratio;
+    max_skip_frames_ = std::max(0, max_skip_frames);
+    Reset();
+}
+
+bool MotionGate::Update(const cv::Mat &frame, const PixelFormat format)
+{
+    if (enable_ == false)
+        return true;
+
+    // downscale first so that only a few thousand pixels are converted and compared
+    const int img_rows = format == PixelFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
+    const cv::Size size(width_, std::max(1, img_rows * width_ / std::max(1, frame.cols)));
+    switch (format)
+    {
+        case PixelFormat::BGR:
+            cv::resize(frame, small_, size, 0, 0, cv::INTER_AREA);
+            cv::cvtColor(small_, gray_, cv::COLOR_BGR2GRAY);
+            break;
+        case PixelFormat::YUYV:
+            // channel 0 of a packed YUYV frame is luma
+            cv::resize(frame, small_, size, 0, 0, cv::INTER_AREA);
+            cv::extractChannel(small_, gray_, 0);
+            break;
+        case PixelFormat::NV12:
+            // the Y plane is luma
+            cv::resize(frame.rowRange(0, img_rows), gray_, size, 0, 0, cv::INTER_AREA);
+            break;
+    }
+    // suppress sensor noise
+    cv::GaussianBlur(gray_, gray_, cv::Size(3, 3), 0);
+
+    if (reference_.empty() || reference_.size() != gray_.size())
+    {
+        gray_.copyTo(reference_);
+        skipped_ = 0;
+        return true;
+    }
+
+    // compare with the last passed frame rather than the previous one, so that slow changes add up
+    cv::absdiff(gray_, reference_, diff_);
+    cv::threshold(diff_, diff_, pixel_thres_, 255, cv::THRESH_BINARY);
+    const float changed_ratio = static_cast<float>(cv::countNonZero(diff_)) / diff_.total();
+
+    if (changed_ratio < min_changed_ratio_ && (max_skip_frames_ == 0 || skipped_ < max_skip_frames_))
+    {
+        ++skipped_;
+        return false;
+    }
+
+    gray_.copyTo(reference_);
+    skipped_ = 0;
+    return true;
+}
+
+void MotionGate::Reset()
+{
+    reference_.release();
+    skipped_ = 0;
+}
+
+}   // namespace Infer
@@ -0,0 +1,99 @@
+#include "pipeline/object_renderer.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Infer
+{
+
+ObjectRenderer::ObjectRenderer(const std::vector<std::string> &labels, const int decimation)
+    : labels_(labels), sprites_(labels.size() * kProbBuckets), decimation_(std::max(1, decimation))
+{
+
+}
+
+int ObjectRenderer::GetDecimation() const
+{
+    return decimation_;
+}
+
+void ObjectRenderer::SetLabels(const std::vector<std::string> &labels)
+{
+    labels_ = labels;
+    sprites_.assign(labels.size() * kProbBuckets, cv::Mat());
+}
+
+void ObjectRenderer::Prepare(const cv::Mat &bgr, cv::Mat &display) const
+{
+    if (decimation_ == 1)
+        display = bgr;
+    else
+        cv::resize(bgr, display, cv::Size(bgr.cols / decimation_, bgr.rows / decimation_), 0, 0, cv::INTER_NEAREST);
+}
+
+void ObjectRenderer::Draw(cv::Mat &display, const std::vector<Object> &objects)
+{
+    const cv::Vec3b color(114, 114, 114);
+    const float scale = 1.0f / decimation_;
+    const int thickness = 2;
+
+    for (const auto &obj : objects)
+    {
+        int x0 = static_cast<int>(std::lround(obj.rect.x * scale));
+        int y0 = static_cast<int>(std::lround(obj.rect.y * scale));
+        int x1 = static_cast<int>(std::lround((obj.rect.x + obj.rect.width) * scale));
+        int y1 = static_cast<int>(std::lround((obj.rect.y + obj.rect.height) * scale));
+
+        // box edges as four filled strips
+        FillRect(display, x0, y0, x1 + 1, y0 + thickness, color);
+        FillRect(display, x0, y1 - thickness + 1, x1 + 1, y1 + 1, color);
+        FillRect(display, x0, y0, x0 + thickness, y1 + 1, color);
+        FillRect(display, x1 - thickness + 1, y0, x1 + 1, y1 + 1, color);
+
+        if (obj.label < 0 || obj.label >= static_cast<int>(labels_.size()))
+            continue;
+
+        // the label box is opaque, so the sprite is copied row by row without blending
+        const cv::Mat &sprite = GetSprite(obj.label, obj.prob);
+        int x = std::max(0, std::min(x0 - 1, display.cols - sprite.cols));
+        int y = std::max(0, y0 - sprite.rows);
+        int w = std::min(sprite.cols, display.cols - x);
+        int h = std::min(sprite.rows, display.rows - y);
+        if (w > 0 && h > 0)
+            sprite(cv::Rect(0, 0, w, h)).copyTo(display(cv::Rect(x, y, w, h)));
+    }
+}
+
+const cv::Mat & ObjectRenderer::GetSprite(const int label, const float prob)
+{
+    const int percent = std::max(0, std::min(kProbBuckets - 1, static_cast<int>(std::lround(prob * 100.0f))));
+    cv::Mat &sprite = sprites_[label * kProbBuckets + percent];
+    if (sprite.empty())
+    {
+        // same look as BaseDetector::DrawObjects
+        std::string text = labels_[label] + " " + std::to_string(percent) + "%";
+        int baseLine = 5;
+        cv::Size label_size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.75, 1, &baseLine);
+        sprite = cv::Mat(label_size.height + baseLine, label_size.width, CV_8UC3, cv::Scalar(114, 114, 114));
+        cv::putText(sprite, text, cv::Point(0, label_size.height + baseLine / 2),
+            cv::FONT_HERSHEY_SIMPLEX, 0.75, cv::Scalar(255, 255, 255), 2);
+    }
+    return sprite;
+}
+
+void ObjectRenderer::FillRect(cv::Mat &image, int x0, int y0, int x1, int y1, const cv::Vec3b &color)
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, image.cols);
+    y1 = std::min(y1, image.rows);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        cv::Vec3b *row = image.ptr<cv::Vec3b>(y);
+        std::fill(row + x0, row + x1, color);
+    }
+}
+
+}   // namespace Infer
@@ -0,0 +1,130 @@
+#include "pipeline/region_filter.hpp"
+
+namespace Infer
+{
+
+void RegionFilter::SetRegions(const std::vector<cv::Point> &roi, const std::vector<std::vector<cv::Point>> &exclusions,
+    const int scale)
+{
+    roi_ = roi;
+    exclusions_ = exclusions;
+    // into the coordinates of downscaled frames
+    if (scale > 1)
+    {
+        for (auto &point : roi_)
+            point /= scale;
+        for (auto &exclusion : exclusions_)
+        {
+            for (auto &point : exclusion)
+                point /= scale;
+        }
+    }
+    bounds_ = roi_.empty() ? cv::Rect() : cv::boundingRect(roi_);
+}
+
+bool RegionFilter::IsEnabled() const
+{
+    return !roi_.empty() || !exclusions_.empty();
+}
+
+std::vector<Object> RegionFilter::Detect(BaseDetector &detector, const cv::Mat &frame,
+    const PixelFormat format) const
+{
+    if (IsEnabled() == false)
+        return detector.Detect(frame, format);
+
+    const int img_rows = format == PixelFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
+    const int img_cols = frame.cols;
+    cv::Rect rect = GetCropRect(img_rows, img_cols, format);
+    if (rect.empty())
+        return {};
+
+    // crop without copying, except for NV12 whose Y and UV planes cannot share one view
+    cv::Mat crop;
+    if (format == PixelFormat::NV12)
+    {
+        crop.create(rect.height * 3 / 2, rect.width, CV_8UC1);
+        frame(rect).copyTo(crop.rowRange(0, rect.height));
+        frame(cv::Rect(rect.x, img_rows + rect.y / 2, rect.width, rect.height / 2))
+            .copyTo(crop.rowRange(rect.height, crop.rows));
+    }
+    else
+    {
+        crop = frame(rect);
+    }
+
+    std::vector<Object> objects = detector.Detect(crop, format);
+
+    // back to frame coordinates, then drop objects outside the mask
+    std::vector<Object> results;
+    for (auto &obj : objects)
+    {
+        obj.rect.x += rect.x;
+        obj.rect.y += rect.y;
+        if (IsInside(obj))
+            results.emplace_back(obj);
+    }
+    return results;
+}
+
+void RegionFilter::DrawRegions(cv::Mat &image, const int decimation) const
+{
+    auto scale = [decimation](const std::vector<cv::Point> &polygon) {
+        std::vector<cv::Point> scaled(polygon);
+        for (auto &point : scaled)
+            point /= decimation;
+        return scaled;
+    };
+    if (!roi_.empty())
+        cv::polylines(image, decimation > 1 ? scale(roi_) : roi_, true, cv::Scalar(0, 255, 0), 2);
+    for (const auto &exclusion : exclusions_)
+        cv::polylines(image, decimation > 1 ? scale(exclusion) : exclusion, true, cv::Scalar(0, 0, 255), 2);
+}
+
+cv::Rect RegionFilter::GetCropRect(const int img_rows, const int img_cols, const PixelFormat format) const
+{
+    cv::Rect rect = roi_.empty() ? cv::Rect(0, 0, img_cols, img_rows) : bounds_ & cv::Rect(0, 0, img_cols, img_rows);
+
+    // chroma is shared by 2 pixels horizontally (YUYV, NV12) and 2 rows vertically (NV12)
+    if (format != PixelFormat::BGR)
+    {
+        int x0 = rect.x & ~1;
+        int x1 = std::min((rect.x + rect.width + 1) & ~1, img_cols & ~1);
+        rect.x = x0;
+        rect.width = x1 - x0;
+    }
+    if (format == PixelFormat::NV12)
+    {
+        int y0 = rect.y & ~1;
+        int y1 = std::min((rect.y + rect.height + 1) & ~1, img_rows & ~1);
+        rect.y = y0;
+        rect.height = y1 - y0;
+    }
+    return rect;
+}
+
+bool RegionFilter::IsInside(const Object &obj) const
+{
+    cv::Point2f center(obj.rect.x + obj.rect.width * 0.5f, obj.rect.y + obj.rect.height * 0.5f);
+    if (!roi_.empty() && cv::pointPolygonTest(roi_, center, false) < 0)
+        return false;
+    for (const auto &exclusion : exclusions_)
+    {
+        if (cv::pointPolygonTest(exclusion, center, false) >= 0)
+            return false;
+    }
+    return true;
+}
+
+void ScaleObjects(std::vector<Object> &objects, const float scale)
+{
+    for (auto &obj : objects)
+    {
+        obj.rect.x *= scale;
+        obj.rect.y *= scale;
+        obj.rect.width *= scale;
+        obj.rect.height *= scale;
+    }
+}
+
+}   // namespace Infer
@@ -0,0 +1,132 @@
+#include "pipeline/resolution_controller.hpp"
+#include <iostream>
+#include <algorithm>
+
+namespace Infer
+{
+
+void ResolutionController::Configure(const std::vector<int> &sizes, const double target_fps,
+    const int min_object_pixels, const int hold_frames, const int window)
+{
+    sizes_ = sizes;
+    std::sort(sizes_.begin(), sizes_.end());
+    sizes_.erase(std::unique(sizes_.begin(), sizes_.end()), sizes_.end());
+    budget_ms_ = target_fps > 0.0 ? 1000.0 / target_fps : 0.0;
+    min_object_pixels_ = std::max(0, min_object_pixels);
+    hold_frames_ = std::max(1, hold_frames);
+    window_ = std::max(1, window);
+
+    current_ = sizes_.empty() ? 0 : static_cast<int>(sizes_.size()) - 1;
+    latency_ms_ = 0.0;
+    smallest_.clear();
+    candidate_ = -1;
+    candidate_frames_ = 0;
+}
+
+int ResolutionController::Prewarm(BaseDetector &detector, const std::function<void(BaseDetector &)> &detect)
+{
+    std::vector<int> supported;
+    for (const int size : sizes_)
+    {
+        if (detector.SetTargetSize(size) == false)
+        {
+            std::cout << "Target size " << size << " is not supported, skipped\n";
+            continue;
+        }
+        detect(detector);
+        supported.push_back(size);
+    }
+    sizes_ = supported;
+    if (sizes_.empty())
+        return 0;
+
+    current_ = static_cast<int>(sizes_.size()) - 1;
+    detector.SetTargetSize(sizes_[current_]);
+    return sizes_[current_];
+}
+
+int ResolutionController::Update(const double latency_ms, const std::vector<Object> &objects,
+    const int img_rows, const int img_cols)
+{
+    if (sizes_.empty())
+        return 0;
+
+    latency_ms_ = latency_ms_ == 0.0 ? latency_ms : 0.8 * latency_ms_ + 0.2 * latency_ms;
+
+    // the smallest object decides how far the input can shrink, empty frames do not vote for shrinking
+    float smallest = kNoObjects;
+    for (const auto &obj : objects)
+        smallest = std::min(smallest, std::min(obj.rect.width, obj.rect.height) / std::max(img_rows, img_cols));
+    smallest_.push_back(smallest);
+    if (static_cast<int>(smallest_.size()) > window_)
+        smallest_.pop_front();
+
+    // hysteresis: a different size must be preferred for several consecutive frames
+    const int selected = SelectSize();
+    if (selected == current_)
+    {
+        candidate_ = -1;
+        candidate_frames_ = 0;
+    }
+    else if (selected != candidate_)
+    {
+        candidate_ = selected;
+        candidate_frames_ = 1;
+    }
+    else if (++candidate_frames_ >= hold_frames_)
+    {
+        // compute grows with the input area
+        const double ratio = static_cast<double>(sizes_[selected]) / sizes_[current_];
+        latency_ms_ *= ratio * ratio;
+        current_ = selected;
+        candidate_ = -1;
+        candidate_frames_ = 0;
+    }
+
+    return sizes_[current_];
+}
+
+int ResolutionController::SelectSize() const
+{
+    const float smallest = smallest_.empty() ? kNoObjects :
+        *std::min_element(smallest_.begin(), smallest_.end());
+
+    // smallest size that still resolves the smallest recent object, the latency budget cannot shrink below it,
+    // without recent objects any size may be used
+    int floor = 0;
+    for (int i = 0; i < static_cast<int>(sizes_.size()) && smallest != kNoObjects; ++i)
+    {
+        floor = i;
+        if (smallest * sizes_[i] >= min_object_pixels_)
+            break;
+    }
+
+    // largest size within the latency budget, growing needs a margin so that it does not oscillate
+    int selected = static_cast<int>(sizes_.size()) - 1;
+    if (budget_ms_ > 0.0 && latency_ms_ > 0.0)
+    {
+        while (selected > floor)
+        {
+            const double ratio = static_cast<double>(sizes_[selected]) / sizes_[current_];
+            const double predicted = latency_ms_ * ratio * ratio;
+            const double limit = selected > current_ ? budget_ms_ * 0.8 : budget_ms_;
+            if (predicted <= limit)
+                break;
+            --selected;
+        }
+    }
+
+    return selected;
+}
+
+int ResolutionController::GetTargetSize() const
+{
+    return sizes_.empty() ? 0 : sizes_[current_];
+}
+
+const std::vector<int> & ResolutionController::GetSizes() const
+{
+    return sizes_;
+}
+
+}   // namespace Infer
@@ -0,0 +1,253 @@
+#include "pipeline/result_log.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+namespace Infer
+{
+
+namespace
+{
+
+constexpr char kMagic[4] = {'Y', 'R', 'E', 'S'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kFileHeaderSize = 8;
+constexpr size_t kChunkHeaderSize = 8;
+
+// bytes of all columns of a chunk, the 2-byte stream column is padded so that chunks stay 8-byte aligned
+size_t GetChunkPayloadSize(const size_t rows)
+{
+    size_t size = rows * (8 + 8 + 5 * 4 + 4 + 2);
+    return (size + 7) / 8 * 8;
+}
+
+/**
+ * @brief check an existing log and drop a chunk cut short by a crash, so that appended chunks follow complete ones
+ * @param path      log file path
+ * @param size      size of the complete part, 0 if the file does not exist or is empty
+ * @return false if the file is not a result log
+ */
+bool GetCompleteSize(const std::string &path, size_t &size)
+{
+    size = 0;
+    std::error_code ec;
+    const uintmax_t file_size = std::filesystem::file_size(path, ec);
+    if (ec || file_size == 0)
+        return true;
+
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    char magic[4] = {};
+    uint32_t version = 0;
+    bool valid = file_size >= kFileHeaderSize && std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+        std::fread(&version, sizeof(version), 1, file) == 1 &&
+        std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 && version == kVersion;
+    if (valid == false)
+    {
+        std::fclose(file);
+        std::cout << "Not a result log: " << path << "\n";
+        return false;
+    }
+
+    // only the chunk headers are read
+    size_t offset = kFileHeaderSize;
+    uint32_t rows;
+    while (offset + kChunkHeaderSize <= file_size && std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+        std::fread(&rows, sizeof(rows), 1, file) == 1)
+    {
+        const size_t next = offset + kChunkHeaderSize + GetChunkPayloadSize(rows);
+        if (next > file_size)
+            break;
+        offset = next;
+    }
+    std::fclose(file);
+
+    if (offset < file_size)
+    {
+        std::cout << "Dropping " << file_size - offset << " bytes of an incomplete chunk in " << path << "\n";
+        std::filesystem::resize_file(path, offset, ec);
+        if (ec)
+            return false;
+    }
+    size = offset;
+    return true;
+}
+
+}   // namespace
+
+ResultLogWriter::~ResultLogWriter()
+{
+    Close();
+}
+
+bool ResultLogWriter::Open(const std::string &path, const size_t chunk_rows)
+{
+    Close();
+    // results of earlier runs are kept, new chunks are appended after them
+    size_t size = 0;
+    if (GetCompleteSize(path, size) == false)
+    {
+        std::cout << "Failed to open result log " << path << "\n";
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "ab");
+    if (file_ == nullptr)
+    {
+        std::cout << "Failed to open result log " << path << "\n";
+        return false;
+    }
+    if (size == 0)
+    {
+        std::fwrite(kMagic, 1, sizeof(kMagic), file_);
+        std::fwrite(&kVersion, sizeof(kVersion), 1, file_);
+    }
+
+    chunk_rows_ = std::max<size_t>(1, chunk_rows);
+    for (auto *column : {&prob_, &x_, &y_, &width_, &height_})
+        column->reserve(chunk_rows_);
+    frame_id_.reserve(chunk_rows_);
+    timestamp_us_.reserve(chunk_rows_);
+    label_.reserve(chunk_rows_);
+    stream_.reserve(chunk_rows_);
+    return true;
+}
+
+void ResultLogWriter::Close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr)
+        return;
+    WriteChunk();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void ResultLogWriter::Append(const uint64_t frame_id, const int64_t timestamp_us, const std::vector<Object> &objects,
+    const uint16_t stream)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr)
+        return;
+
+    if (objects.empty())
+        AppendRow(frame_id, timestamp_us, -1, 0.0f, cv::Rect_<float>(), stream);
+    for (const auto &obj : objects)
+        AppendRow(frame_id, timestamp_us, obj.label, obj.prob, obj.rect, stream);
+}
+
+void ResultLogWriter::AppendRow(const uint64_t frame_id, const int64_t timestamp_us, const int32_t label,
+    const float prob, const cv::Rect_<float> &rect, const uint16_t stream)
+{
+    frame_id_.push_back(frame_id);
+    timestamp_us_.push_back(timestamp_us);
+    prob_.push_back(prob);
+    x_.push_back(rect.x);
+    y_.push_back(rect.y);
+    width_.push_back(rect.width);
+    height_.push_back(rect.height);
+    label_.push_back(label);
+    stream_.push_back(stream);
+
+    if (frame_id_.size() >= chunk_rows_)
+        WriteChunk();
+}
+
+void ResultLogWriter::WriteChunk()
+{
+    const size_t rows = frame_id_.size();
+    if (rows == 0)
+        return;
+
+    // each column is written as one block, the whole chunk is a few large writes
+    const uint32_t header[2] = {static_cast<uint32_t>(rows), 0};
+    std::fwrite(header, sizeof(header), 1, file_);
+    std::fwrite(frame_id_.data(), sizeof(uint64_t), rows, file_);
+    std::fwrite(timestamp_us_.data(), sizeof(int64_t), rows, file_);
+    for (const auto *column : {&prob_, &x_, &y_, &width_, &height_})
+        std::fwrite(column->data(), sizeof(float), rows, file_);
+    std::fwrite(label_.data(), sizeof(int32_t), rows, file_);
+    std::fwrite(stream_.data(), sizeof(uint16_t), rows, file_);
+    const size_t padding = GetChunkPayloadSize(rows) - rows * (8 + 8 + 5 * 4 + 4 + 2);
+    const char zeros[8] = {};
+    std::fwrite(zeros, 1, padding, file_);
+    std::fflush(file_);
+
+    frame_id_.clear();
+    timestamp_us_.clear();
+    for (auto *column : {&prob_, &x_, &y_, &width_, &height_})
+        column->clear();
+    label_.clear();
+    stream_.clear();
+}
+
+bool ResultLogReader::Open(const std::string &path)
+{
+    chunks_.clear();
+    rows_ = 0;
+    if (file_.Open(path) == false)
+        return false;
+
+    const unsigned char *data = file_.Data();
+    const size_t size = file_.Size();
+    uint32_t version = 0;
+    if (size >= kFileHeaderSize)
+        std::memcpy(&version, data + 4, sizeof(version));
+    if (size < kFileHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0 || version != kVersion)
+    {
+        std::cout << "Not a result log: " << path << "\n";
+        file_.Close();
+        return false;
+    }
+
+    size_t offset = kFileHeaderSize;
+    while (offset + kChunkHeaderSize <= size)
+    {
+        uint32_t rows;
+        std::memcpy(&rows, data + offset, sizeof(rows));
+        const size_t payload = GetChunkPayloadSize(rows);
+        if (offset + kChunkHeaderSize + payload > size)
+            break;
+
+        // the file and chunk headers keep every column 8-byte aligned within the page-aligned mapping
+        const unsigned char *ptr = data + offset + kChunkHeaderSize;
+        ResultChunk chunk;
+        chunk.rows = rows;
+        chunk.frame_id = reinterpret_cast<const uint64_t *>(ptr);
+        ptr += rows * sizeof(uint64_t);
+        chunk.timestamp_us = reinterpret_cast<const int64_t *>(ptr);
+        ptr += rows * sizeof(int64_t);
+        const float **float_columns[] = {&chunk.prob, &chunk.x, &chunk.y, &chunk.width, &chunk.height};
+        for (const float **column : float_columns)
+        {
+            *column = reinterpret_cast<const float *>(ptr);
+            ptr += rows * sizeof(float);
+        }
+        chunk.label = reinterpret_cast<const int32_t *>(ptr);
+        ptr += rows * sizeof(int32_t);
+        chunk.stream = reinterpret_cast<const uint16_t *>(ptr);
+
+        chunks_.push_back(chunk);
+        rows_ += rows;
+        offset += kChunkHeaderSize + payload;
+    }
+    return true;
+}
+
+size_t ResultLogReader::GetChunkCount() const
+{
+    return chunks_.size();
+}
+
+const ResultChunk & ResultLogReader::GetChunk(const size_t index) const
+{
+    return chunks_[index];
+}
+
+size_t ResultLogReader::GetRowCount() const
+{
+    return rows_;
+}
+
+}   // namespace Infer
@@ -0,0 +1,523 @@
+#include "pipeline/shm_ring.hpp"
+#include <iostream>
+#include <chrono>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <new>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Infer
+{
+
+namespace
+{
+
+constexpr uint32_t kMagic = 0x35564f59;   // "YOV5"
+constexpr uint32_t kVersion = 2;
+
+// without a free slot, slots of crashed processes are looked for at this interval
+constexpr int kReclaimPollMs = 100;
+
+// slot states
+constexpr uint32_t kFree = 0;
+constexpr uint32_t kWriting = 1;
+constexpr uint32_t kReady = 2;
+constexpr uint32_t kProcessing = 3;
+constexpr uint32_t kDone = 4;
+constexpr uint32_t kCancelled = 5;    // given up by the producer while processing, freed by the detector
+
+// the futex words and slot states are shared between processes, so they must not depend on a lock table
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex words must be lock-free");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "slot states must be lock-free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit words");
+
+size_t AlignUp(const size_t value, const size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief sleep while the word still holds the expected value, shared between processes
+ */
+void FutexWait(std::atomic<uint32_t> &word, const uint32_t expected, const int timeout_ms)
+{
+    timespec timeout;
+    timespec *ptimeout = nullptr;
+    if (timeout_ms >= 0)
+    {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000;
+        ptimeout = &timeout;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, ptimeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// a slot state holds the state and the pid of the process holding the slot, so that both change at once
+uint64_t MakeState(const uint32_t state, const int32_t pid)
+{
+    return static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32 | state;
+}
+
+uint32_t GetState(const uint64_t value)
+{
+    return static_cast<uint32_t>(value);
+}
+
+int32_t GetHolder(const uint64_t value)
+{
+    return static_cast<int32_t>(value >> 32);
+}
+
+bool IsProcessDead(const int32_t pid)
+{
+    return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+/**
+ * @brief wait until the condition holds, the sequence word is bumped whenever the condition may have changed
+ * @param seq           sequence word to sleep on
+ * @param timeout_ms    maximum wait, negative to wait forever
+ * @param condition     checked after reading the sequence so that a wake-up in between is not lost
+ * @return whether the condition held before the timeout
+ */
+template <typename Condition>
+bool WaitFor(std::atomic<uint32_t> &seq, const int timeout_ms, Condition condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true)
+    {
+        uint32_t value = seq.load(std::memory_order_acquire);
+        if (condition())
+            return true;
+
+        int remaining = -1;
+        if (timeout_ms >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+                return false;
+            remaining = static_cast<int>(left.count());
+        }
+        FutexWait(seq, value, remaining);
+    }
+}
+
+}   // namespace
+
+struct ShmRing::Header
+{
+    std::atomic<uint32_t> magic;    // set last by the creator
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t max_objects;
+    uint64_t max_frame_bytes;
+    uint64_t slot_stride;
+    // on separate cache lines since producers and detectors bump them independently
+    alignas(64) std::atomic<uint32_t> frame_seq;    // bumped when a frame is published
+    alignas(64) std::atomic<uint32_t> result_seq;   // bumped when results are published
+    alignas(64) std::atomic<uint32_t> free_seq;     // bumped when a slot is freed
+};
+
+// each slot: Slot header, max_objects ShmObject records, then the frame data
+struct ShmRing::Slot
+{
+    // state in the low 32 bits, pid of the holding process in the high 32 bits: the producer while
+    // writing, ready and done, the detector while processing and cancelled
+    std::atomic<uint64_t> state;
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+    uint64_t frame_id;
+    uint32_t num_objects;
+    int32_t producer_pid;   // process that acquired the slot, set before the frame is published
+};
+
+namespace
+{
+
+constexpr size_t kHeaderSize = 4096;
+constexpr size_t kSlotHeaderSize = 64;
+
+size_t GetObjectsSize(const uint32_t max_objects)
+{
+    return AlignUp(max_objects * sizeof(ShmObject), 64);
+}
+
+size_t GetFrameBytes(const int width, const int height, const PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::BGR:
+            return static_cast<size_t>(width) * height * 3;
+        case PixelFormat::YUYV:
+            return static_cast<size_t>(width) * height * 2;
+        case PixelFormat::NV12:
+            return static_cast<size_t>(width) * height * 3 / 2;
+    }
+    return 0;
+}
+
+}   // namespace
+
+ShmRing::~ShmRing()
+{
+    Close();
+}
+
+bool ShmRing::Create(const std::string &name, const int slot_count, const size_t max_frame_bytes, const int max_objects)
+{
+    Close();
+    if (slot_count <= 0 || max_frame_bytes == 0 || max_objects < 0)
+        return false;
+
+    static_assert(sizeof(Header) <= kHeaderSize, "header does not fit");
+    static_assert(sizeof(Slot) <= kSlotHeaderSize, "slot header does not fit");
+    size_t slot_stride = AlignUp(kSlotHeaderSize + GetObjectsSize(max_objects) + max_frame_bytes, 4096);
+    size_t size = kHeaderSize + slot_stride * slot_count;
+
+    // a ring left behind by a crashed process is replaced
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0)
+    {
+        std::cout << "Failed to create shared memory " << name << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || Map(fd, size) == false)
+    {
+        std::cout << "Failed to map shared memory " << name << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    close(fd);
+    name_ = name;
+    owner_ = true;
+
+    // the new mapping is zero-filled, so every slot starts free
+    header_ = new (base_) Header();
+    header_->version = kVersion;
+    header_->slot_count = static_cast<uint32_t>(slot_count);
+    header_->max_objects = static_cast<uint32_t>(max_objects);
+    header_->max_frame_bytes = max_frame_bytes;
+    header_->slot_stride = slot_stride;
+    for (int i = 0; i < slot_count; ++i)
+        new (GetSlot(i)) Slot();
+    // published last so that processes attaching early do not see a half-initialized ring
+    header_->magic.store(kMagic, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::Open(const std::string &name)
+{
+    Close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        std::cout << "Failed to open shared memory " << name << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize ||
+        Map(fd, static_cast<size_t>(st.st_size)) == false)
+    {
+        close(fd);
+        return false;
+    }
+    close(fd);
+    name_ = name;
+    owner_ = false;
+
+    header_ = reinterpret_cast<Header *>(base_);
+    if (header_->magic.load(std::memory_order_acquire) != kMagic || header_->version != kVersion ||
+        kHeaderSize + header_->slot_stride * header_->slot_count > size_)
+    {
+        std::cout << "Invalid shared memory ring " << name << "\n";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ShmRing::Close()
+{
+    if (base_ != nullptr)
+        munmap(base_, size_);
+    if (owner_)
+        shm_unlink(name_.c_str());
+    base_ = nullptr;
+    header_ = nullptr;
+    size_ = 0;
+    owner_ = false;
+    name_.clear();
+}
+
+bool ShmRing::Map(const int fd, const size_t size)
+{
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+    base_ = static_cast<uint8_t *>(ptr);
+    size_ = size;
+    return true;
+}
+
+int ShmRing::GetSlotCount() const
+{
+    return header_ != nullptr ? static_cast<int>(header_->slot_count) : 0;
+}
+
+size_t ShmRing::GetMaxFrameBytes() const
+{
+    return header_ != nullptr ? header_->max_frame_bytes : 0;
+}
+
+ShmRing::Slot * ShmRing::GetSlot(const int slot) const
+{
+    return reinterpret_cast<Slot *>(base_ + kHeaderSize + header_->slot_stride * slot);
+}
+
+ShmObject * ShmRing::GetObjects(const int slot) const
+{
+    return reinterpret_cast<ShmObject *>(reinterpret_cast<uint8_t *>(GetSlot(slot)) + kSlotHeaderSize);
+}
+
+uint8_t * ShmRing::GetFrameData(const int slot)
+{
+    return reinterpret_cast<uint8_t *>(GetSlot(slot)) + kSlotHeaderSize + GetObjectsSize(header_->max_objects);
+}
+
+int ShmRing::AcquireSlot(const int timeout_ms)
+{
+    int acquired = -1;
+    auto try_acquire = [this, &acquired]() {
+        const uint32_t count = header_->slot_count;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t index = (cursor_.load(std::memory_order_relaxed) + i) % count;
+            uint64_t expected = MakeState(kFree, 0);
+            if (GetSlot(index)->state.compare_exchange_strong(expected, MakeState(kWriting, getpid()),
+                std::memory_order_acquire))
+            {
+                GetSlot(index)->producer_pid = static_cast<int32_t>(getpid());
+                acquired = static_cast<int>(index);
+                cursor_.store(index + 1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // a crashed process wakes nobody, so the wait is split to look for its slots in between
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true)
+    {
+        int wait_ms = kReclaimPollMs;
+        if (timeout_ms >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            wait_ms = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(left.count(), kReclaimPollMs)));
+        }
+        if (WaitFor(header_->free_seq, wait_ms, try_acquire))
+            return acquired;
+        if (ReclaimSlots())
+            continue;
+        if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline)
+            return -1;
+    }
+}
+
+void ShmRing::CancelSlot(const int slot)
+{
+    Slot *s = GetSlot(slot);
+    uint64_t value = s->state.load(std::memory_order_acquire);
+    uint32_t state;
+    while (true)
+    {
+        state = GetState(value);
+        if (state == kFree || state == kCancelled)
+            return;
+        // a detector working on the frame frees the slot when it publishes the results
+        uint64_t next = state == kProcessing ? MakeState(kCancelled, GetHolder(value)) : MakeState(kFree, 0);
+        if (s->state.compare_exchange_weak(value, next, std::memory_order_acq_rel))
+            break;
+    }
+    if (state != kProcessing)
+    {
+        header_->free_seq.fetch_add(1, std::memory_order_release);
+        FutexWake(header_->free_seq);
+    }
+}
+
+bool ShmRing::ReclaimSlots()
+{
+    bool freed = false, requeued = false;
+    for (int i = 0; i < static_cast<int>(header_->slot_count); ++i)
+    {
+        Slot *s = GetSlot(i);
+        uint64_t value = s->state.load(std::memory_order_acquire);
+        const uint32_t state = GetState(value);
+        if (state == kFree || IsProcessDead(GetHolder(value)) == false)
+            continue;
+
+        // a frame taken by a crashed detector is detected again if its producer still waits for it
+        uint64_t next = MakeState(kFree, 0);
+        if (state == kProcessing && IsProcessDead(s->producer_pid) == false)
+            next = MakeState(kReady, s->producer_pid);
+        // another process may have changed the slot since it was read
+        if (s->state.compare_exchange_strong(value, next, std::memory_order_acq_rel) == false)
+            continue;
+        freed |= GetState(next) == kFree;
+        requeued |= GetState(next) == kReady;
+    }
+    if (freed)
+    {
+        header_->free_seq.fetch_add(1, std::memory_order_release);
+        FutexWake(header_->free_seq);
+    }
+    if (requeued)
+    {
+        header_->frame_seq.fetch_add(1, std::memory_order_release);
+        FutexWake(header_->frame_seq);
+    }
+    return freed;
+}
+
+bool ShmRing::PublishFrame(const int slot, const uint64_t frame_id, const int width, const int height, const PixelFormat format)
+{
+    size_t bytes = GetFrameBytes(width, height, format);
+    if (width <= 0 || height <= 0 || bytes > header_->max_frame_bytes)
+        return false;
+
+    Slot *s = GetSlot(slot);
+    s->format = static_cast<uint32_t>(format);
+    s->width = width;
+    s->height = height;
+    s->frame_id = frame_id;
+    s->num_objects = 0;
+    s->state.store(MakeState(kReady, s->producer_pid), std::memory_order_release);
+
+    header_->frame_seq.fetch_add(1, std::memory_order_release);
+    FutexWake(header_->frame_seq);
+    return true;
+}
+
+bool ShmRing::WaitResult(const int slot, std::vector<Object> &objects, const int timeout_ms)
+{
+    Slot *s = GetSlot(slot);
+    if (WaitFor(header_->result_seq, timeout_ms,
+        [s]() { return GetState(s->state.load(std::memory_order_acquire)) == kDone; }) == false)
+        return false;
+
+    const ShmObject *records = GetObjects(slot);
+    objects.resize(s->num_objects);
+    for (uint32_t i = 0; i < s->num_objects; ++i)
+    {
+        objects[i].label = records[i].label;
+        objects[i].prob = records[i].prob;
+        objects[i].rect = cv::Rect_<float>(records[i].x, records[i].y, records[i].width, records[i].height);
+    }
+
+    s->state.store(MakeState(kFree, 0), std::memory_order_release);
+    header_->free_seq.fetch_add(1, std::memory_order_release);
+    FutexWake(header_->free_seq);
+    return true;
+}
+
+int ShmRing::WaitFrame(const int timeout_ms)
+{
+    int taken = -1;
+    auto try_take = [this, &taken]() {
+        const uint32_t count = header_->slot_count;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t index = (cursor_.load(std::memory_order_relaxed) + i) % count;
+            uint64_t expected = GetSlot(index)->state.load(std::memory_order_relaxed);
+            if (GetState(expected) == kReady && GetSlot(index)->state.compare_exchange_strong(
+                expected, MakeState(kProcessing, getpid()), std::memory_order_acquire))
+            {
+                taken = static_cast<int>(index);
+                cursor_.store(index + 1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    };
+    WaitFor(header_->frame_seq, timeout_ms, try_take);
+    return taken;
+}
+
+cv::Mat ShmRing::GetFrame(const int slot, PixelFormat &format, uint64_t &frame_id)
+{
+    const Slot *s = GetSlot(slot);
+    frame_id = s->frame_id;
+
+    // the header is written by another process, read once and checked so that a frame
+    // that does not fit the slot is never read
+    const uint32_t raw_format = s->format;
+    const int width = s->width;
+    const int height = s->height;
+    if (raw_format > static_cast<uint32_t>(PixelFormat::NV12) || width <= 0 || height <= 0)
+        return cv::Mat();
+    format = static_cast<PixelFormat>(raw_format);
+    if ((format == PixelFormat::NV12 && height % 2 != 0) ||
+        GetFrameBytes(width, height, format) > header_->max_frame_bytes)
+        return cv::Mat();
+
+    switch (format)
+    {
+        case PixelFormat::BGR:
+            return cv::Mat(height, width, CV_8UC3, GetFrameData(slot));
+        case PixelFormat::YUYV:
+            return cv::Mat(height, width, CV_8UC2, GetFrameData(slot));
+        case PixelFormat::NV12:
+            return cv::Mat(height * 3 / 2, width, CV_8UC1, GetFrameData(slot));
+    }
+    return cv::Mat();
+}
+
+void ShmRing::PublishResult(const int slot, const std::vector<Object> &objects)
+{
+    Slot *s = GetSlot(slot);
+    ShmObject *records = GetObjects(slot);
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(objects.size(), header_->max_objects));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        records[i].label = objects[i].label;
+        records[i].prob = objects[i].prob;
+        records[i].x = objects[i].rect.x;
+        records[i].y = objects[i].rect.y;
+        records[i].width = objects[i].rect.width;
+        records[i].height = objects[i].rect.height;
+    }
+    s->num_objects = count;
+
+    // the producer gave up on the slot while it was processed
+    uint64_t expected = MakeState(kProcessing, getpid());
+    if (s->state.compare_exchange_strong(expected, MakeState(kDone, s->producer_pid), std::memory_order_acq_rel) == false)
+    {
+        s->state.store(MakeState(kFree, 0), std::memory_order_release);
+        header_->free_seq.fetch_add(1, std::memory_order_release);
+        FutexWake(header_->free_seq);
+        return;
+    }
+
+    header_->result_seq.fetch_add(1, std::memory_order_release);
+    FutexWake(header_->result_seq);
+}
+
+}   // namespace Infer
@@ -0,0 +1,169 @@
+#include "pipeline/stream_runner.hpp"
+
+namespace Infer
+{
+
+MultiStreamRunner::MultiStreamRunner(DetectorPool &pool, const SchedulePolicy policy, const int deadline_ms)
+    : pool_(pool), scheduler_(policy, deadline_ms)
+{
+
+}
+
+MultiStreamRunner::~MultiStreamRunner()
+{
+    Stop();
+}
+
+size_t MultiStreamRunner::AddStream(std::unique_ptr<StreamSource> source)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.emplace_back();
+    streams_.back().source = std::move(source);
+    return streams_.size() - 1;
+}
+
+size_t MultiStreamRunner::GetStreamCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+void MultiStreamRunner::Start(Callback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_)
+            return;
+        running_ = true;
+        callback_ = std::move(callback);
+        last_stats_ = std::chrono::steady_clock::now();
+    }
+
+    for (size_t i = 0; i < pool_.Size(); ++i)
+        workers_.emplace_back(&MultiStreamRunner::WorkerLoop, this);
+
+    // capture threads wake the workers whenever a frame arrives
+    for (auto &stream : streams_)
+    {
+        stream.source->Start([this]() {
+            // lock so that the notification cannot fall between a worker's check and its wait
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            cv_.notify_all();
+        });
+    }
+}
+
+void MultiStreamRunner::Stop()
+{
+    for (auto &stream : streams_)
+        stream.source->Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    for (auto &worker : workers_)
+        worker.join();
+    workers_.clear();
+}
+
+bool MultiStreamRunner::IsFinished() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return IsFinishedLocked();
+}
+
+bool MultiStreamRunner::IsFinishedLocked() const
+{
+    for (const auto &stream : streams_)
+        if (stream.busy || !stream.source->IsFinished())
+            return false;
+    return true;
+}
+
+std::vector<StreamStats> MultiStreamRunner::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_stats_).count();
+    last_stats_ = now;
+
+    std::vector<StreamStats> stats;
+    stats.reserve(streams_.size());
+    for (auto &stream : streams_)
+    {
+        StreamStats s;
+        s.name = stream.source->GetName();
+        s.captured = stream.source->GetCapturedCount();
+        s.dropped = stream.source->GetDroppedCount();
+        s.detected = stream.detected;
+        s.skipped = stream.skipped;
+        if (elapsed > 0.0)
+        {
+            s.capture_fps = (s.captured - stream.last_captured) / elapsed;
+            s.detect_fps = (s.detected - stream.last_detected) / elapsed;
+        }
+        stream.last_captured = s.captured;
+        stream.last_detected = s.detected;
+        stats.push_back(s);
+    }
+
+    return stats;
+}
+
+void MultiStreamRunner::WorkerLoop()
+{
+    std::vector<StreamScheduler::Candidate> candidates;
+    candidates.reserve(streams_.size());
+
+    while (true)
+    {
+        StreamFrame frame;
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // a stream is detected by one worker at a time so that its frames stay in order
+            // and its motion gate and results need no locking
+            cv_.wait(lock, [this, &candidates]() {
+                candidates.clear();
+                if (!running_)
+                    return true;
+                std::chrono::steady_clock::time_point timestamp;
+                for (size_t i = 0; i < streams_.size(); ++i)
+                    if (!streams_[i].busy && streams_[i].source->PeekTimestamp(timestamp))
+                        candidates.push_back({i, streams_[i].source->GetWeight(), timestamp});
+                return !candidates.empty() || IsFinishedLocked();
+            });
+            if (candidates.empty())
+                break;
+
+            index = scheduler_.Pick(candidates);
+            streams_[index].source->TakeFrame(frame);
+            streams_[index].busy = true;
+        }
+
+        StreamSource &source = *streams_[index].source;
+        bool detect = source.motion_gate.Update(frame.image, frame.format);
+        if (detect)
+        {
+            auto detector = pool_.Acquire();
+            source.last_objects = source.region_filter.Detect(*detector, frame.image, frame.format);
+        }
+        callback_(index, frame, source.last_objects);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            streams_[index].busy = false;
+            if (detect)
+                ++streams_[index].detected;
+            else
+                ++streams_[index].skipped;
+        }
+        // the stream may have a new frame waiting, and finishing may have completed the run
+        cv_.notify_all();
+    }
+}
+
+}   // namespace Infer
@@ -0,0 +1,53 @@
+#include "pipeline/stream_scheduler.hpp"
+#include <algorithm>
+
+namespace Infer
+{
+
+bool ParseSchedulePolicy(const std::string &name, SchedulePolicy &policy)
+{
+    if (name == "WeightedRoundRobin")
+        policy = SchedulePolicy::WeightedRoundRobin;
+    else if (name == "Deadline")
+        policy = SchedulePolicy::Deadline;
+    else
+        return false;
+    return true;
+}
+
+StreamScheduler::StreamScheduler(const SchedulePolicy policy, const int deadline_ms)
+    : policy_(policy), deadline_(std::chrono::milliseconds(std::max(1, deadline_ms)))
+{
+
+}
+
+size_t StreamScheduler::Pick(const std::vector<Candidate> &candidates)
+{
+    if (policy_ == SchedulePolicy::Deadline)
+    {
+        // earliest deadline first, a frame of weight w is due deadline / w after capture
+        auto due = [this](const Candidate &c) { return c.timestamp + deadline_ / c.weight; };
+        return std::min_element(candidates.begin(), candidates.end(),
+            [&due](const Candidate &a, const Candidate &b) { return due(a) < due(b); })->stream;
+    }
+
+    // smooth weighted round robin (as in nginx): every ready stream earns its weight,
+    // the richest one is picked and pays the total, so picks interleave instead of bursting
+    int total = 0;
+    size_t best = 0;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        const Candidate &c = candidates[i];
+        if (c.stream >= current_.size())
+            current_.resize(c.stream + 1, 0);
+        current_[c.stream] += c.weight;
+        total += c.weight;
+        if (current_[c.stream] > current_[candidates[best].stream])
+            best = i;
+    }
+    current_[candidates[best].stream] -= total;
+
+    return candidates[best].stream;
+}
+
+}   // namespace Infer
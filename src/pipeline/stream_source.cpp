@@ -0,0 +1,151 @@
+#include "pipeline/stream_source.hpp"
+#include <algorithm>
+
+namespace Infer
+{
+
+StreamSource::StreamSource(const std::string &name, int weight)
+    : name_(name), weight_(std::max(1, weight))
+{
+
+}
+
+StreamSource::~StreamSource()
+{
+    Stop();
+}
+
+bool StreamSource::Open(const std::string &source, int width, int height, int fps,
+    PixelFormat format, bool mjpeg, int min_size)
+{
+    bool is_device = !source.empty() && std::all_of(source.begin(), source.end(), ::isdigit);
+    if (!is_device)
+        return camera_.Open(source, width, height, fps);
+
+    camera_.SetPixelFormat(format);
+    camera_.SetMJPEG(mjpeg, min_size);
+    return camera_.Open(std::stoi(source), width, height, fps);
+}
+
+void StreamSource::Start(std::function<void()> on_frame)
+{
+    if (running_)
+        return;
+    on_frame_ = std::move(on_frame);
+    running_ = true;
+    finished_ = false;
+    thread_ = std::thread(&StreamSource::CaptureLoop, this);
+}
+
+void StreamSource::Stop()
+{
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+bool StreamSource::TakeFrame(StreamFrame &frame)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_frame_)
+        return false;
+    frame = std::move(frame_);
+    has_frame_ = false;
+    return true;
+}
+
+bool StreamSource::HasFrame() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_frame_;
+}
+
+bool StreamSource::PeekTimestamp(std::chrono::steady_clock::time_point &timestamp) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_frame_)
+        return false;
+    timestamp = frame_.timestamp;
+    return true;
+}
+
+bool StreamSource::IsFinished() const
+{
+    return finished_ && !HasFrame();
+}
+
+const std::string & StreamSource::GetName() const
+{
+    return name_;
+}
+
+int StreamSource::GetWeight() const
+{
+    return weight_;
+}
+
+int StreamSource::GetFrameScale() const
+{
+    return camera_.GetFrameScale();
+}
+
+uint64_t StreamSource::GetCapturedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return captured_;
+}
+
+uint64_t StreamSource::GetDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void StreamSource::CaptureLoop()
+{
+    // files are read at their own frame rate instead of as fast as possible
+    const bool is_paced = !camera_.IsDevice() && camera_.GetActualFPS() > 0;
+    const auto period = std::chrono::microseconds(is_paced ? 1000000 / camera_.GetActualFPS() : 0);
+    auto next = std::chrono::steady_clock::now();
+    uint64_t next_id = 0;
+
+    while (running_)
+    {
+        // read into a new buffer since workers may still hold the previous frame
+        cv::Mat image;
+        if (!camera_.GetFrame(image))
+        {
+            std::cout << "Stream " << name_ << " ended\n";
+            break;
+        }
+
+        // a corrupt frame is skipped, the stream goes on
+        if (!image.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (has_frame_)
+                    ++dropped_;
+                frame_.image = image;
+                frame_.format = camera_.GetPixelFormat();
+                frame_.scale = camera_.GetFrameScale();
+                frame_.id = next_id++;
+                frame_.timestamp = std::chrono::steady_clock::now();
+                has_frame_ = true;
+                ++captured_;
+            }
+            on_frame_();
+        }
+
+        if (is_paced)
+        {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    finished_ = true;
+    on_frame_();
+}
+
+}   // namespace Infer
@@ -0,0 +1,164 @@
+"""Append YOLOv5 decoding and NonMaxSuppression to an ONNX model.
+
+The input model is expected to have the same outputs as the models used by the detectors:
+three post-sigmoid heads (or raw logits with --raw-logits) in NHWC layout with shape [1, H, W, 3 * (num_classes + 5)],
+ordered by stride (8, 16, 32). The output model has a single output "detections" with
+shape [K, 6], each row being x0, y0, x1, y1, score, label in letterbox coordinates.
+
+Usage:
+    python tools/add_nms_head.py models/ONNXRuntime/yolov5n.onnx models/ONNXRuntime/yolov5n-nms.onnx
+
+Convert the output to OpenVINO IR with `ovc yolov5n-nms.onnx` to use it with OVDetector.
+"""
+
+import argparse
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+STRIDES = [8, 16, 32]
+ANCHORS = [
+    [10.0, 13.0, 16.0, 30.0, 33.0, 23.0],
+    [30.0, 61.0, 62.0, 45.0, 59.0, 119.0],
+    [116.0, 90.0, 156.0, 198.0, 373.0, 326.0],
+]
+
+
+class GraphBuilder:
+    def __init__(self, graph, opset):
+        self.graph = graph
+        self.opset = opset
+        self.count = 0
+
+    def const(self, value, dtype=np.float32):
+        name = f"nms_head/const_{self.count}"
+        self.count += 1
+        self.graph.initializer.append(numpy_helper.from_array(np.asarray(value, dtype=dtype), name))
+        return name
+
+    def node(self, op, inputs, output=None, **attrs):
+        name = f"nms_head/{op}_{self.count}"
+        self.count += 1
+        output = output or name + ":0"
+        self.graph.node.append(helper.make_node(op, inputs, [output], name=name, **attrs))
+        return output
+
+    def slice(self, data, start, end, axis):
+        return self.node("Slice", [
+            data,
+            self.const([start], np.int64),
+            self.const([end], np.int64),
+            self.const([axis], np.int64),
+        ])
+
+    def reshape(self, data, shape):
+        return self.node("Reshape", [data, self.const(shape, np.int64)])
+
+    def grid(self, shape, axis, view):
+        # float coordinates 0..dim-1 of one feature map axis, reshaped for broadcasting
+        dim = self.node("Gather", [shape, self.const(axis, np.int64)], axis=0)
+        index = self.node("Range", [self.const(0, np.int64), dim, self.const(1, np.int64)])
+        index = self.node("Cast", [index], to=TensorProto.FLOAT)
+        return self.reshape(index, view)
+
+
+def decode_head(g, output, stride, anchors, num_classes, raw_logits):
+    num_anchors = len(anchors) // 2
+    # [1, H, W, na * no] -> [1, H, W, na, no]
+    pred = g.reshape(output, [0, 0, 0, num_anchors, num_classes + 5])
+    if raw_logits:
+        pred = g.node("Sigmoid", [pred])
+    shape = g.node("Shape", [output])
+    grid_y = g.grid(shape, 1, [1, -1, 1, 1, 1])
+    grid_x = g.grid(shape, 2, [1, 1, -1, 1, 1])
+    anchor_w = g.const(np.array(anchors[0::2], np.float32).reshape(1, 1, 1, num_anchors, 1))
+    anchor_h = g.const(np.array(anchors[1::2], np.float32).reshape(1, 1, 1, num_anchors, 1))
+    two, half, s = g.const(2.0), g.const(0.5), g.const(float(stride))
+
+    def center(d, grid):
+        # (d * 2 - 0.5 + grid) * stride
+        v = g.node("Sub", [g.node("Mul", [d, two]), half])
+        return g.node("Mul", [g.node("Add", [v, grid]), s])
+
+    def size(d, anchor):
+        # (d * 2) ^ 2 * anchor
+        v = g.node("Mul", [d, two])
+        return g.node("Mul", [g.node("Mul", [v, v]), anchor])
+
+    cx = center(g.slice(pred, 0, 1, 4), grid_x)
+    cy = center(g.slice(pred, 1, 2, 4), grid_y)
+    half_w = g.node("Mul", [size(g.slice(pred, 2, 3, 4), anchor_w), half])
+    half_h = g.node("Mul", [size(g.slice(pred, 3, 4, 4), anchor_h), half])
+    boxes = g.node("Concat", [
+        g.node("Sub", [cx, half_w]),
+        g.node("Sub", [cy, half_h]),
+        g.node("Add", [cx, half_w]),
+        g.node("Add", [cy, half_h]),
+    ], axis=4)
+    # confidence = objectness * class score
+    scores = g.node("Mul", [g.slice(pred, 4, 5, 4), g.slice(pred, 5, 5 + num_classes, 4)])
+    return g.reshape(boxes, [1, -1, 4]), g.reshape(scores, [1, -1, num_classes])
+
+
+def add_nms_head(model, num_classes, conf_thres, iou_thres, max_det, raw_logits):
+    graph = model.graph
+    opset = next(o.version for o in model.opset_import if o.domain in ("", "ai.onnx"))
+    if opset < 11:
+        raise ValueError(f"opset {opset} is too old, at least 11 is required for Range")
+    if len(graph.output) != len(STRIDES):
+        raise ValueError(f"expected {len(STRIDES)} outputs, got {len(graph.output)}")
+
+    g = GraphBuilder(graph, opset)
+    boxes, scores = [], []
+    for output, stride, anchors in zip(graph.output, STRIDES, ANCHORS):
+        b, s = decode_head(g, output.name, stride, anchors, num_classes, raw_logits)
+        boxes.append(b)
+        scores.append(s)
+    boxes = g.node("Concat", boxes, axis=1)      # [1, N, 4]
+    scores = g.node("Concat", scores, axis=1)    # [1, N, num_classes]
+
+    # class-agnostic NMS on the best class of each box, same as the host implementation
+    if opset >= 18:
+        conf = g.node("ReduceMax", [scores, g.const([2], np.int64)], keepdims=0)
+    else:
+        conf = g.node("ReduceMax", [scores], axes=[2], keepdims=0)
+    label = g.node("ArgMax", [scores], axis=2, keepdims=0)
+    selected = g.node("NonMaxSuppression", [
+        boxes,
+        g.reshape(conf, [1, 1, -1]),
+        g.const([max_det], np.int64),
+        g.const([iou_thres]),
+        g.const([conf_thres]),
+    ])
+    index = g.node("Gather", [selected, g.const(2, np.int64)], axis=1)
+
+    det_boxes = g.node("Gather", [g.reshape(boxes, [-1, 4]), index], axis=0)
+    det_scores = g.node("Gather", [g.reshape(conf, [-1, 1]), index], axis=0)
+    det_labels = g.node("Gather", [g.reshape(g.node("Cast", [label], to=TensorProto.FLOAT), [-1, 1]), index], axis=0)
+    g.node("Concat", [det_boxes, det_scores, det_labels], output="detections", axis=1)
+
+    del graph.output[:]
+    graph.output.append(helper.make_tensor_value_info("detections", TensorProto.FLOAT, ["num_detections", 6]))
+    return model
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="input .onnx model")
+    parser.add_argument("output", help="output .onnx model")
+    parser.add_argument("--num-classes", type=int, default=80)
+    parser.add_argument("--conf-thres", type=float, default=0.4)
+    parser.add_argument("--iou-thres", type=float, default=0.45)
+    parser.add_argument("--max-det", type=int, default=300)
+    parser.add_argument("--raw-logits", action="store_true", help="the heads were exported without the final sigmoid")
+    args = parser.parse_args()
+
+    model = onnx.load(args.input)
+    model = add_nms_head(model, args.num_classes, args.conf_thres, args.iou_thres, args.max_det, args.raw_logits)
+    onnx.checker.check_model(model)
+    onnx.save(model, args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+"""Print the detection stream published by detect_camera on a Unix domain socket.
+
+Each record is little-endian: uint32 length of the rest of the record, uint64 frame id,
+int64 capture timestamp in microseconds since the Unix epoch, uint32 object count, then per object
+int32 label, float32 prob, float32 x, y, width, height in image pixels.
+
+Usage:
+    python tools/subscribe_detections.py /tmp/yolov5_detections.sock
+"""
+
+import argparse
+import socket
+import struct
+
+HEADER = struct.Struct("<IQqI")
+OBJECT = struct.Struct("<ifffff")
+
+
+def read_exact(sock, size):
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("publisher closed the stream")
+        data += chunk
+    return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("socket_path", nargs="?", default="/tmp/yolov5_detections.sock")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(args.socket_path)
+    while True:
+        length, = struct.unpack("<I", read_exact(sock, 4))
+        body = read_exact(sock, length)
+        _, frame_id, timestamp_us, count = HEADER.unpack_from(b"\0\0\0\0" + body)
+        objects = [OBJECT.unpack_from(body, HEADER.size - 4 + i * OBJECT.size) for i in range(count)]
+        print(f"frame {frame_id} at {timestamp_us} us: {count} objects")
+        for label, prob, x, y, width, height in objects:
+            print(f"  label {label} prob {prob:.2f} box [{x:.0f}, {y:.0f}, {width:.0f}, {height:.0f}]")
+
+
+if __name__ == "__main__":
+    main()